@@ -1,5 +1,25 @@
 #include "Ini.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
 #define INI_NAMESPACE_START namespace qini {
 #define INI_NAMESPACE_END }
 
@@ -168,16 +188,38 @@ bool operator!=(const INIObject::const_iterator &a,
   return a.m_itor != b.m_itor;
 }
 
-INIObject::INIObject(const INIObject &ob) : m_sections(ob.m_sections) {}
+/**
+ * @brief Unparsed section bodies of an object built by lazyParse().
+ */
+struct INIObject::LazySections {
+  struct Chunk {
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  std::string data;
+  std::unordered_map<std::string, std::vector<Chunk>> pending;
+  std::atomic<std::size_t> pendingCount{0}; ///< pending.size(), lock-free.
+  std::mutex mutex;
+};
+
+INIObject::INIObject(const INIObject &ob) {
+  ob.materialize_();
+  m_sections = ob.m_sections;
+}
 
 INIObject::INIObject(INIObject &&ob) noexcept
-    : m_sections(std::move(ob.m_sections)) {}
+    : m_sections(std::move(ob.m_sections)), m_lazy(std::move(ob.m_lazy)),
+      m_sectionHashes(std::move(ob.m_sectionHashes)) {}
 
 INIObject &INIObject::operator=(const INIObject &ob) {
   if (this == &ob)
     return *this;
 
+  ob.materialize_();
   m_sections = ob.m_sections;
+  m_lazy.reset();
+  m_sectionHashes.clear();
   return *this;
 }
 
@@ -186,17 +228,23 @@ INIObject &INIObject::operator=(INIObject &&ob) noexcept {
     return *this;
 
   m_sections = std::move(ob.m_sections);
+  m_lazy = std::move(ob.m_lazy);
+  m_sectionHashes = std::move(ob.m_sectionHashes);
   return *this;
 }
 
 INIObject::Section INIObject::operator[](const std::string &sectionName) {
   // if (m_sections.find(sectionName) == m_sections.end()) throw
   // std::logic_error("Invalid Section Name");
-  return Section(m_sections[sectionName]);
+  materialize_(sectionName);
+  auto &keys = m_sections[sectionName];
+  m_sectionHashes[&keys].exposed = true;
+  return Section(keys);
 }
 
 INIObject::ConstSection
 qini::INIObject::operator[](const std::string &sectionName) const {
+  materialize_(sectionName);
   auto iter = m_sections.find(sectionName);
   if (iter == m_sections.end())
     throw std::logic_error("Invalid Section Name");
@@ -204,25 +252,300 @@ qini::INIObject::operator[](const std::string &sectionName) const {
 }
 
 INIObject::iterator INIObject::begin() {
+  materialize_();
+  for (const auto &[section, keys] : m_sections)
+    m_sectionHashes[&keys].exposed = true;
   return {std::move(m_sections.begin())};
 }
 
-INIObject::iterator INIObject::end() { return {std::move(m_sections.end())}; }
+INIObject::iterator INIObject::end() {
+  materialize_();
+  return {std::move(m_sections.end())};
+}
 
 bool operator==(const INIObject &ia, const INIObject &ib) {
+  ia.materialize_();
+  ib.materialize_();
   return ia.m_sections == ib.m_sections;
 }
 
 bool operator!=(const INIObject &ia, const INIObject &ib) {
-  return ia.m_sections != ib.m_sections;
+  return !(ia == ib);
+}
+
+void INIObject::materialize_(const std::string &sectionName) const {
+  if (!m_lazy || m_lazy->pendingCount.load(std::memory_order_acquire) == 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_lazy->mutex);
+  if (m_lazy->pending.find(sectionName) != m_lazy->pending.end())
+    parsePending_(sectionName);
+  if (m_lazy->pending.empty())
+    std::string().swap(m_lazy->data);
+}
+
+void INIObject::materialize_() const {
+  if (!m_lazy || m_lazy->pendingCount.load(std::memory_order_acquire) == 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_lazy->mutex);
+  while (!m_lazy->pending.empty())
+    parsePending_(std::string(m_lazy->pending.begin()->first));
+  std::string().swap(m_lazy->data);
+}
+
+void INIObject::parsePending_(const std::string &sectionName) const {
+  auto &lazy = *m_lazy;
+  auto iter = lazy.pending.find(sectionName);
+  const std::string_view data = lazy.data;
+
+  // Parse every chunk before touching the section, so that a syntax error
+  // leaves it pending and the next access reports the error again.
+  INIParser parser;
+  INIObject localObject;
+  for (const auto &chunk : iter->second) {
+    const auto text = data.substr(chunk.begin, chunk.end - chunk.begin);
+    try {
+      parser.parse_(text, localObject, 0);
+    } catch (const std::logic_error &) {
+      INIObject discarded;
+      parser.parse_(text, discarded,
+                    std::count(data.begin(), data.begin() + chunk.begin,
+                               '\n'));
+      throw;
+    }
+  }
+
+  auto &keys = m_sections.find(sectionName)->second;
+  auto &parsed = localObject.m_sections[sectionName];
+  if (keys.empty()) {
+    keys.swap(parsed);
+  } else {
+    for (auto &[key, value] : parsed)
+      keys.insert_or_assign(key, std::move(value));
+  }
+
+  lazy.pending.erase(iter);
+  lazy.pendingCount.store(lazy.pending.size(), std::memory_order_release);
+}
+
+std::optional<std::size_t>
+INIObject::sectionHash_(const keys_t &keys) const {
+  SectionHash &entry = m_sectionHashes[&keys];
+  if (entry.exposed)
+    return std::nullopt;
+  if (entry.known)
+    return entry.value;
+
+  // Order-independent: unordered maps with equal content may iterate
+  // differently.
+  std::hash<std::string_view> hasher;
+  std::size_t hash = keys.size();
+  for (const auto &[key, value] : keys) {
+    std::size_t pair =
+        hasher(key) * static_cast<std::size_t>(0x9e3779b97f4a7c15ULL);
+    pair ^= hasher(value) + (pair << 6) + (pair >> 2);
+    hash += pair;
+  }
+  entry.value = hash;
+  entry.known = true;
+  return hash;
+}
+
+// INIDiff
+
+bool INIDiff::empty() const noexcept {
+  return addedSections.empty() && removedSections.empty() &&
+         changedSections.empty();
+}
+
+INIDiff diff(const INIObject &from, const INIObject &to) {
+  INIDiff result;
+  if (&from == &to)
+    return result;
+
+  from.materialize_();
+  to.materialize_();
+  std::scoped_lock lock(from.m_hashMutex, to.m_hashMutex);
+  for (const auto &[section, keys] : from.m_sections) {
+    auto toIter = to.m_sections.find(section);
+    if (toIter == to.m_sections.end()) {
+      result.removedSections.push_back(section);
+      continue;
+    }
+    const auto &toKeys = toIter->second;
+    if (keys.size() == toKeys.size()) {
+      const auto fromHash = from.sectionHash_(keys);
+      if (fromHash && fromHash == to.sectionHash_(toKeys))
+        continue;
+    }
+
+    INIDiff::SectionDiff sectionDiff;
+    for (const auto &[key, value] : keys) {
+      auto keyIter = toKeys.find(key);
+      if (keyIter == toKeys.end())
+        sectionDiff.removed.push_back(key);
+      else if (keyIter->second != value)
+        sectionDiff.changed.emplace(key, keyIter->second);
+    }
+    for (const auto &[key, value] : toKeys) {
+      if (keys.find(key) == keys.end())
+        sectionDiff.added.emplace(key, value);
+    }
+    if (!sectionDiff.added.empty() || !sectionDiff.changed.empty() ||
+        !sectionDiff.removed.empty())
+      result.changedSections.emplace(section, std::move(sectionDiff));
+  }
+
+  for (const auto &[section, keys] : to.m_sections) {
+    if (from.m_sections.find(section) == from.m_sections.end())
+      result.addedSections.emplace(section, keys);
+  }
+  return result;
+}
+
+void patch(INIObject &ob, const INIDiff &changes) {
+  ob.materialize_();
+  auto &sections = ob.m_sections;
+  // Changed sections are rehashed by the next diff(); exposed ones stay so.
+  auto rehash = [&ob](const INIObject::keys_t &keys) {
+    auto iter = ob.m_sectionHashes.find(&keys);
+    if (iter != ob.m_sectionHashes.end())
+      iter->second.known = false;
+  };
+  for (const auto &section : changes.removedSections) {
+    auto iter = sections.find(section);
+    if (iter == sections.end())
+      continue;
+    ob.m_sectionHashes.erase(&iter->second);
+    sections.erase(iter);
+  }
+
+  for (const auto &[section, keys] : changes.addedSections) {
+    auto &target = sections[section];
+    rehash(target);
+    for (const auto &[key, value] : keys)
+      target.insert_or_assign(key, value);
+  }
+
+  for (const auto &[section, sectionDiff] : changes.changedSections) {
+    auto &target = sections[section];
+    rehash(target);
+    for (const auto &key : sectionDiff.removed)
+      target.erase(key);
+    for (const auto &[key, value] : sectionDiff.added)
+      target.insert_or_assign(key, value);
+    for (const auto &[key, value] : sectionDiff.changed)
+      target.insert_or_assign(key, value);
+  }
 }
 
+namespace {
+/**
+ * @brief Instrumentation policy of the plain parse(): every hook only runs
+ * the token reader, and inlines away.
+ */
+struct NoInstrument {
+  template <class Read> std::string header(Read &&read) { return read(); }
+  template <class Read> std::string key(Read &&read) { return read(); }
+  template <class Read> std::string value(Read &&read) { return read(); }
+  void stored(bool) noexcept {}
+};
+
+/**
+ * @brief Instrumentation policy filling an INIParseStats.
+ */
+class StatsInstrument {
+public:
+  explicit StatsInstrument(INIParseStats &stats) : m_stats(stats) {}
+
+  template <class Read> std::string header(Read &&read) {
+    ++m_stats.sections;
+    return timed(m_stats.time.headers, read);
+  }
+
+  template <class Read> std::string key(Read &&read) {
+    std::string key = timed(m_stats.time.keys, read);
+    ++m_stats.keys;
+    m_stats.keyBytes += key.size();
+    return key;
+  }
+
+  template <class Read> std::string value(Read &&read) {
+    std::string value = timed(m_stats.time.values, read);
+    m_stats.valueBytes += value.size();
+    m_stats.maxValueLength = std::max(m_stats.maxValueLength, value.size());
+    return value;
+  }
+
+  void stored(bool overwrote) noexcept { m_stats.overwrites += overwrote; }
+
+private:
+  template <class Read>
+  std::string timed(std::chrono::nanoseconds &total, Read &read) {
+    if (!m_stats.timePhases)
+      return read();
+    const auto start = std::chrono::steady_clock::now();
+    std::string result = read();
+    total += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    return result;
+  }
+
+  INIParseStats &m_stats;
+};
+} // namespace
+
 INIObject INIParser::parse(std::string_view data) {
   INIObject localObject;
-  long long error_line = 0;
+  parse_(data, localObject, 0);
+  return localObject;
+}
 
+INIObject INIParser::parse(std::string_view data, INIParseStats &stats) {
+  INIParseStats fresh;
+  fresh.timePhases = stats.timePhases;
+  fresh.tracer = std::move(stats.tracer);
+  stats = std::move(fresh);
+
+  StatsInstrument instrument(stats);
+  const auto start = std::chrono::steady_clock::now();
+  auto finish = [&] {
+    stats.time.total = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (stats.tracer)
+      stats.tracer(stats);
+  };
+  INIObject localObject;
+  try {
+    parse_(data, localObject, 0, nullptr, instrument);
+  } catch (...) {
+    stats.failed = true;
+    finish();
+    throw;
+  }
+  stats.bytes = data.size();
+  stats.lines = std::count(data.begin(), data.end(), '\n') +
+                (!data.empty() && data.back() != '\n');
+  finish();
+  return localObject;
+}
+
+void INIParser::parse_(std::string_view data, INIObject &localObject,
+                       long long error_line, IncludeContext *context) {
+  NoInstrument instrument;
+  parse_(data, localObject, error_line, context, instrument);
+}
+
+template <class Instrument>
+void INIParser::parse_(std::string_view data, INIObject &localObject,
+                       long long error_line, IncludeContext *context,
+                       Instrument &instrument) {
   std::string localSection;
-  for (auto i = data.begin(); i != data.end(); i++) {
+  // Each branch leaves i on the first character it didn't consume; headers
+  // and entries must end their line, which skipSpace() then steps over,
+  // counting the line ends it passes.
+  for (auto i = data.begin(); i != data.end();) {
     if (!skipSpace(i, data, error_line))
       break;
 
@@ -231,7 +554,8 @@ INIObject INIParser::parse(std::string_view data) {
       if (!skipSpace(i, data, error_line))
         throw std::logic_error(getLogicErrorString(error_line));
 
-      localSection = getString(i, data, error_line);
+      localSection =
+          instrument.header([&] { return getString(i, data, error_line); });
 
       if (!skipSpace(i, data, error_line))
         throw std::logic_error(getLogicErrorString(error_line));
@@ -240,25 +564,36 @@ INIObject INIParser::parse(std::string_view data) {
         i++;
       else
         throw std::logic_error(getLogicErrorString(error_line));
+      endLine(i, data, error_line);
     } else if (*i == '=') {
       throw std::logic_error(getLogicErrorString(error_line));
+    } else if (*i == '@' && context != nullptr) {
+      auto lineEnd = std::find(i, data.end(), '\n');
+      include_({i, lineEnd}, localObject, *context, error_line);
+      i = lineEnd;
+      if (i == data.end())
+        break;
     } else {
       if (localSection.empty())
         throw std::logic_error(getLogicErrorString(error_line));
 
-      std::string localKey = getString(i, data, error_line);
+      std::string localKey =
+          instrument.key([&] { return getString(i, data, error_line); });
 
-      if (*i == '=')
+      if (i != data.end() && *i == '=')
         i++;
       else
         throw std::logic_error(getLogicErrorString(error_line));
 
-      localObject.m_sections[localSection][localKey] =
-          getString(i, data, error_line);
+      std::string value =
+          instrument.value([&] { return getString(i, data, error_line); });
+      endLine(i, data, error_line);
+      auto &keys = localObject.m_sections[localSection];
+      const std::size_t keyCount = keys.size();
+      keys[std::move(localKey)] = std::move(value);
+      instrument.stored(keys.size() == keyCount);
     }
   }
-
-  return localObject;
 }
 
 INIObject qini::INIParser::fastParse(std::string_view data) {
@@ -278,6 +613,365 @@ INIObject qini::INIParser::fastParse(std::ifstream &infile) {
   return INIParser::fastParse(buffer);
 }
 
+INIObject INIParser::parallelParse(std::string_view data,
+                                   std::size_t threadCount) {
+  constexpr std::size_t min_chunk_size = 256 * 1024;
+
+  if (threadCount == 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  threadCount = std::min(threadCount, data.size() / min_chunk_size);
+  if (threadCount <= 1)
+    return parse(data);
+
+  std::vector<std::size_t> starts = splitSections_(data, threadCount);
+  const std::size_t chunkCount = starts.size();
+  if (chunkCount == 1)
+    return parse(data);
+
+  auto chunkOf = [&](std::size_t k) {
+    std::size_t end = k + 1 < chunkCount ? starts[k + 1] : data.size();
+    return data.substr(starts[k], end - starts[k]);
+  };
+
+  std::vector<INIObject> partials(chunkCount);
+  std::vector<std::exception_ptr> errors(chunkCount);
+  auto work = [&](std::size_t k) {
+    try {
+      parse_(chunkOf(k), partials[k], 0);
+    } catch (...) {
+      errors[k] = std::current_exception();
+    }
+  };
+
+  // Chunks no thread could be started for are parsed on this one; the
+  // jthreads already started are joined however this scope is left.
+  std::vector<std::jthread> workers;
+  workers.reserve(chunkCount - 1);
+  std::size_t started = 1;
+  try {
+    for (; started < chunkCount; started++)
+      workers.emplace_back(work, started);
+  } catch (const std::system_error &) {
+  }
+  work(0);
+  for (std::size_t k = started; k < chunkCount; k++)
+    work(k);
+  for (auto &worker : workers)
+    worker.join();
+
+  for (std::size_t k = 0; k < chunkCount; k++) {
+    if (!errors[k])
+      continue;
+    // Re-parse the failing chunk with its starting line so the error
+    // refers to the whole buffer rather than to the chunk.
+    INIObject discard;
+    parse_(chunkOf(k), discard,
+           std::count(data.begin(), data.begin() + starts[k], '\n'));
+    std::rethrow_exception(errors[k]);
+  }
+
+  INIObject localObject = std::move(partials[0]);
+  auto &sections = localObject.m_sections;
+  for (std::size_t k = 1; k < chunkCount; k++) {
+    auto &from = partials[k].m_sections;
+    while (!from.empty()) {
+      auto sectionNode = from.extract(from.begin());
+      auto sectionIter = sections.find(sectionNode.key());
+      if (sectionIter == sections.end()) {
+        sections.insert(std::move(sectionNode));
+        continue;
+      }
+      auto &keys = sectionIter->second;
+      auto &newKeys = sectionNode.mapped();
+      while (!newKeys.empty()) {
+        auto result = keys.insert(newKeys.extract(newKeys.begin()));
+        if (!result.inserted)
+          result.position->second = std::move(result.node.mapped());
+      }
+    }
+  }
+  return localObject;
+}
+
+INIObject INIParser::lazyParse(std::string data) {
+  INIObject localObject;
+  localObject.m_lazy = std::make_shared<INIObject::LazySections>();
+  auto &lazy = *localObject.m_lazy;
+  lazy.data = std::move(data);
+  const std::string_view view = lazy.data;
+
+  struct Header {
+    std::string_view name;
+    std::size_t begin;
+    bool eager; ///< Its chunk holds a '[' that doesn't start a line.
+  };
+  std::vector<Header> headers;
+
+  auto isBlank = [](char c) { return c == ' ' || c == '\t' || c == '\0'; };
+  for (std::size_t pos = view.find('['); pos != std::string_view::npos;
+       pos = view.find('[', pos + 1)) {
+    std::size_t lineStart = pos;
+    while (lineStart > 0 && isBlank(view[lineStart - 1]))
+      lineStart--;
+    if (lineStart > 0 && view[lineStart - 1] != '\n') {
+      // A header after a key or a '[' in a comment: parse that chunk
+      // now rather than guess which section it belongs to.
+      if (!headers.empty())
+        headers.back().eager = true;
+      continue;
+    }
+
+    std::size_t i = pos + 1;
+    while (i < view.size() && isBlank(view[i]))
+      i++;
+    const std::size_t nameBegin = i;
+    while (i < view.size() && !isBlank(view[i]) && view[i] != '\n' &&
+           view[i] != '[' && view[i] != ']' && view[i] != '=' &&
+           view[i] != ';')
+      i++;
+    const std::size_t nameEnd = i;
+    while (i < view.size() && isBlank(view[i]))
+      i++;
+    if (nameBegin == nameEnd || i == view.size() || view[i] != ']') {
+      // Malformed header: let the regular parser report it.
+      const auto keepAlive = std::move(localObject.m_lazy);
+      parse_(view, localObject, 0);
+      return localObject;
+    }
+    headers.push_back(
+        {view.substr(nameBegin, nameEnd - nameBegin), pos, false});
+  }
+
+  // Keys before the first header are an error; comments are not.
+  parse_(view.substr(0, headers.empty() ? view.size() : headers[0].begin),
+         localObject, 0);
+
+  for (std::size_t k = 0; k < headers.size(); k++) {
+    const std::size_t begin = headers[k].begin;
+    const std::size_t end =
+        k + 1 < headers.size() ? headers[k + 1].begin : view.size();
+    std::string name(headers[k].name);
+    localObject.m_sections.try_emplace(name);
+
+    if (!headers[k].eager) {
+      lazy.pending[std::move(name)].push_back({begin, end});
+      continue;
+    }
+
+    INIObject chunkObject;
+    const auto text = view.substr(begin, end - begin);
+    try {
+      parse_(text, chunkObject, 0);
+    } catch (const std::logic_error &) {
+      parse_(text, chunkObject,
+             std::count(view.begin(), view.begin() + begin, '\n'));
+      throw;
+    }
+    // Earlier chunks of the same sections go first.
+    for (auto &[section, keys] : chunkObject.m_sections) {
+      if (lazy.pending.find(section) != lazy.pending.end())
+        localObject.parsePending_(section);
+      auto &target = localObject.m_sections[section];
+      for (auto &[key, value] : keys)
+        target.insert_or_assign(key, std::move(value));
+    }
+  }
+
+  lazy.pendingCount.store(lazy.pending.size(), std::memory_order_release);
+  if (lazy.pending.empty())
+    localObject.m_lazy.reset();
+  return localObject;
+}
+
+std::vector<std::size_t> INIParser::splitSections_(std::string_view data,
+                                                   std::size_t chunkCount) {
+  std::vector<std::size_t> starts{0};
+  starts.reserve(chunkCount);
+
+  for (std::size_t k = 1; k < chunkCount; k++) {
+    std::size_t pos = std::max(data.size() / chunkCount * k, starts.back());
+    while (true) {
+      pos = data.find('\n', pos);
+      if (pos == std::string_view::npos)
+        return starts;
+      pos++;
+      while (pos < data.size() && (data[pos] == ' ' || data[pos] == '\t'))
+        pos++;
+      if (pos < data.size() && data[pos] == '[')
+        break;
+    }
+    starts.push_back(pos);
+  }
+  return starts;
+}
+
+namespace {
+struct FileStamp {
+  std::filesystem::path path;
+  std::filesystem::file_time_type mtime;
+  std::uintmax_t size = 0;
+  unsigned long long device = 0;
+  unsigned long long inode = 0;
+
+  friend bool operator==(const FileStamp &, const FileStamp &) = default;
+};
+
+struct CachedInclude {
+  std::shared_ptr<const INIObject> object;
+  std::vector<FileStamp> stamps; ///< The file and everything it includes.
+};
+
+std::mutex include_cache_mutex;
+std::unordered_map<std::string, CachedInclude> include_cache;
+
+FileStamp stampOf(const std::filesystem::path &path) {
+  FileStamp stamp;
+  stamp.path = path;
+  std::error_code ec;
+  stamp.mtime = std::filesystem::last_write_time(path, ec);
+  stamp.size = std::filesystem::file_size(path, ec);
+#ifndef _WIN32
+  struct stat info{};
+  if (::stat(path.c_str(), &info) == 0) {
+    stamp.device = static_cast<unsigned long long>(info.st_dev);
+    stamp.inode = static_cast<unsigned long long>(info.st_ino);
+  }
+#endif
+  return stamp;
+}
+
+bool isFresh(const CachedInclude &entry) {
+  for (const auto &stamp : entry.stamps) {
+    if (stampOf(stamp.path) != stamp)
+      return false;
+  }
+  return true;
+}
+
+std::string readFile(const std::filesystem::path &path) {
+  std::ifstream infile(path, std::ios_base::binary);
+  if (!infile)
+    throw std::logic_error("Cannot open file: " + path.string());
+  infile.seekg(0, std::ios_base::end);
+  std::size_t size = infile.tellg();
+  infile.seekg(0, std::ios_base::beg);
+  std::string buffer;
+  buffer.resize(size);
+  infile.read(buffer.data(), size);
+  return buffer;
+}
+} // namespace
+
+struct INIParser::IncludeContext {
+  std::filesystem::path directory;
+  std::vector<std::filesystem::path> &stack;
+  std::vector<FileStamp> &stamps;
+};
+
+INIObject INIParser::parseFile(const std::filesystem::path &path) {
+  std::filesystem::path canonical = std::filesystem::weakly_canonical(path);
+  std::string buffer = readFile(canonical);
+
+  std::vector<std::filesystem::path> stack{canonical};
+  std::vector<FileStamp> stamps;
+  IncludeContext context{canonical.parent_path(), stack, stamps};
+
+  INIObject localObject;
+  parse_(buffer, localObject, 0, &context);
+  return localObject;
+}
+
+void INIParser::clearIncludeCache() {
+  std::lock_guard<std::mutex> lock(include_cache_mutex);
+  include_cache.clear();
+}
+
+void INIParser::include_(std::string_view directive, INIObject &localObject,
+                         IncludeContext &context, long long error_line) {
+  constexpr std::string_view blank = " \t\r";
+
+  constexpr std::string_view comment = ";#";
+
+  std::size_t nameEnd = std::min(directive.find_first_of(blank),
+                                 directive.find_first_of(comment));
+  std::string_view name = directive.substr(0, nameEnd);
+  if (name != "@include" && name != "@import")
+    throw std::logic_error(getLogicErrorString(error_line));
+
+  std::string_view target;
+  if (nameEnd != std::string_view::npos) {
+    target = directive.substr(nameEnd);
+    target.remove_prefix(std::min(target.find_first_not_of(blank),
+                                  target.size()));
+    // A ';' or '#' starts a comment, as in skipSpace(), except inside a
+    // quoted path.
+    std::size_t commentFrom = 0;
+    if (!target.empty() && (target.front() == '"' || target.front() == '\'')) {
+      const std::size_t close = target.find(target.front(), 1);
+      if (close != std::string_view::npos)
+        commentFrom = close + 1;
+    }
+    target = target.substr(0, target.find_first_of(comment, commentFrom));
+    target = target.substr(0, target.find_last_not_of(blank) + 1);
+  }
+  if (target.size() >= 2 && (target.front() == '"' || target.front() == '\'') &&
+      target.back() == target.front())
+    target = target.substr(1, target.size() - 2);
+  if (target.empty())
+    throw std::logic_error(getLogicErrorString(error_line));
+
+  std::filesystem::path path(target);
+  if (path.is_relative())
+    path = context.directory / path;
+  std::error_code ec;
+  path = std::filesystem::weakly_canonical(path, ec);
+  if (ec || !std::filesystem::is_regular_file(path))
+    throw std::logic_error("Cannot open included file: " + std::string(target) +
+                           " , in line " + std::to_string(error_line));
+  if (std::find(context.stack.begin(), context.stack.end(), path) !=
+      context.stack.end())
+    throw std::logic_error("Include cycle detected: " + path.string() +
+                           " , in line " + std::to_string(error_line));
+
+  const std::string cacheKey = path.string();
+  CachedInclude entry;
+  {
+    std::lock_guard<std::mutex> lock(include_cache_mutex);
+    auto iter = include_cache.find(cacheKey);
+    if (iter != include_cache.end())
+      entry = iter->second;
+  }
+
+  if (!entry.object || !isFresh(entry)) {
+    // Stamp before reading so that a concurrent edit invalidates the entry.
+    entry.stamps.assign(1, stampOf(path));
+    std::string buffer = readFile(path);
+
+    context.stack.push_back(path);
+    IncludeContext nested{path.parent_path(), context.stack, entry.stamps};
+    auto object = std::make_shared<INIObject>();
+    try {
+      parse_(buffer, *object, 0, &nested);
+    } catch (...) {
+      context.stack.pop_back();
+      throw;
+    }
+    context.stack.pop_back();
+    entry.object = std::move(object);
+
+    std::lock_guard<std::mutex> lock(include_cache_mutex);
+    include_cache.insert_or_assign(cacheKey, entry);
+  }
+
+  context.stamps.insert(context.stamps.end(), entry.stamps.begin(),
+                        entry.stamps.end());
+  for (const auto &[section, keys] : entry.object->m_sections) {
+    auto &target = localObject.m_sections[section];
+    for (const auto &[key, value] : keys)
+      target.insert_or_assign(key, value);
+  }
+}
+
 bool INIParser::skipSpace(std::string_view::iterator &i, std::string_view data,
                           long long &error_line) {
   while (i != data.end() && (*i == ' ' || *i == '\n' || *i == '\t' ||
@@ -307,11 +1001,181 @@ std::string INIParser::getString(std::string_view::iterator &i,
   return localString;
 }
 
+void INIParser::endLine(std::string_view::iterator &i, std::string_view data,
+                        long long error_line) {
+  while (i != data.end() && (*i == ' ' || *i == '\t'))
+    i++;
+  if (i != data.end() && *i != '\n' && *i != ';' && *i != '#')
+    throw std::logic_error(getLogicErrorString(error_line));
+}
+
 std::string qini::INIParser::getLogicErrorString(long long error_line) {
   return "Invalid Input, in line " + std::to_string(error_line);
 }
 
+// INIReader
+
+INIReader::INIReader(std::size_t chunkSize)
+    : m_chunkSize(chunkSize == 0 ? 1 : chunkSize) {}
+
+bool INIReader::read(int fd, const callback_t &callback) {
+  reset();
+  m_chunk.resize(m_chunkSize);
+  try {
+    while (true) {
+#ifdef _WIN32
+      int count =
+          ::_read(fd, m_chunk.data(), static_cast<unsigned>(m_chunkSize));
+#else
+      ssize_t count = ::read(fd, m_chunk.data(), m_chunkSize);
+      if (count < 0 && errno == EINTR)
+        continue;
+#endif
+      if (count < 0)
+        throw std::logic_error("Cannot read input");
+      if (count == 0)
+        return finish(callback);
+      if (!feed({m_chunk.data(), static_cast<std::size_t>(count)},
+                callback)) {
+        reset();
+        return false;
+      }
+    }
+  } catch (...) {
+    reset();
+    throw;
+  }
+}
+
+bool INIReader::read(std::istream &input, const callback_t &callback) {
+  reset();
+  m_chunk.resize(m_chunkSize);
+  try {
+    while (input) {
+      input.read(m_chunk.data(), static_cast<std::streamsize>(m_chunkSize));
+      auto count = static_cast<std::size_t>(input.gcount());
+      if (count != 0 && !feed({m_chunk.data(), count}, callback)) {
+        reset();
+        return false;
+      }
+    }
+    if (input.bad())
+      throw std::logic_error("Cannot read input");
+    return finish(callback);
+  } catch (...) {
+    reset();
+    throw;
+  }
+}
+
+bool INIReader::feed(std::string_view chunk, const callback_t &callback) {
+  if (m_stopped)
+    return false;
+
+  std::size_t pos = 0;
+  if (!m_partial.empty()) {
+    std::size_t end = chunk.find('\n');
+    if (end == std::string_view::npos) {
+      m_partial.append(chunk);
+      return true;
+    }
+    m_partial.append(chunk.substr(0, end));
+    bool go_on = line_(m_partial, callback);
+    m_partial.clear();
+    if (!go_on)
+      return false;
+    pos = end + 1;
+  }
+
+  for (std::size_t end; (end = chunk.find('\n', pos)) != std::string_view::npos;
+       pos = end + 1) {
+    if (!line_(chunk.substr(pos, end - pos), callback))
+      return false;
+  }
+  m_partial.assign(chunk.substr(pos));
+  return true;
+}
+
+bool INIReader::finish(const callback_t &callback) {
+  bool go_on = !m_stopped;
+  if (go_on && !m_partial.empty())
+    go_on = line_(m_partial, callback);
+  reset();
+  return go_on;
+}
+
+void INIReader::reset() {
+  m_partial.clear();
+  m_section.clear();
+  m_line = 0;
+  m_stopped = false;
+}
+
+bool INIReader::line_(std::string_view line, const callback_t &callback) {
+  m_line++;
+
+  auto isBlank = [](char c) { return c == ' ' || c == '\t' || c == '\0'; };
+  auto isDelimiter = [&](char c) {
+    return isBlank(c) || c == '[' || c == ']' || c == '=' || c == ';';
+  };
+  std::size_t i = 0;
+  auto skipBlank = [&] {
+    while (i < line.size() && isBlank(line[i]))
+      i++;
+  };
+  auto getString = [&] {
+    std::size_t start = i;
+    while (i < line.size() && !isDelimiter(line[i]))
+      i++;
+    return line.substr(start, i - start);
+  };
+  auto expectEnd = [&] {
+    skipBlank();
+    if (i < line.size() && line[i] != ';' && line[i] != '#')
+      throw std::logic_error(getLogicErrorString());
+  };
+
+  skipBlank();
+  if (i == line.size() || line[i] == ';' || line[i] == '#')
+    return true;
+
+  if (line[i] == '[') {
+    i++;
+    skipBlank();
+    std::string_view section = getString();
+    skipBlank();
+    if (section.empty() || i == line.size() || line[i] != ']')
+      throw std::logic_error(getLogicErrorString());
+    i++;
+    expectEnd();
+    m_section.assign(section);
+    return true;
+  }
+
+  if (m_section.empty() || line[i] == '=')
+    throw std::logic_error(getLogicErrorString());
+  std::string_view key = getString();
+  skipBlank();
+  if (i == line.size() || line[i] != '=')
+    throw std::logic_error(getLogicErrorString());
+  i++;
+  skipBlank();
+  std::string_view value = getString();
+  expectEnd();
+
+  if (!callback(m_section, key, value)) {
+    m_stopped = true;
+    return false;
+  }
+  return true;
+}
+
+std::string INIReader::getLogicErrorString() const {
+  return "Invalid Input, in line " + std::to_string(m_line);
+}
+
 std::string INIWriter::write(const INIObject &ob) {
+  ob.materialize_();
   std::string localString;
   for (const auto &[section, keys] : ob.m_sections) {
     localString += "[" + section + "]\n";
@@ -326,6 +1190,7 @@ bool INIWriter::write(const INIObject &ob, std::ofstream &file) {
   if (!file)
     return false;
 
+  ob.materialize_();
   file.clear();
   for (const auto &[section, keys] : ob.m_sections) {
     file << "[" + section + "]\n";
@@ -348,4 +1213,326 @@ bool INIWriter::fastWrite(const INIObject &ob, std::ofstream &file) {
   return writer.write(ob, file);
 }
 
+// INILayeredObject
+
+std::size_t INILayeredObject::addLayer(INIObject layer) {
+  const std::size_t index = m_layers.size();
+  m_layers.push_back(std::move(layer));
+  m_layers.back().materialize_();
+
+  for (const auto &[section, keys] : m_layers.back().m_sections) {
+    for (const auto &[key, value] : keys) {
+      auto iter = m_index.find(INIKeyView{section, key});
+      if (iter == m_index.end())
+        m_index.emplace(INIKey{section, key}, Entry{&value, index});
+      else
+        iter->second = Entry{&value, index};
+    }
+  }
+  return index;
+}
+
+void INILayeredObject::reloadLayer(std::size_t index, INIObject layer) {
+  if (index >= m_layers.size())
+    throw std::logic_error("Invalid Layer Index");
+
+  // Keep the old layer alive until every entry pointing into it is redone.
+  layer.materialize_();
+  INIObject old = std::exchange(m_layers[index], std::move(layer));
+
+  for (const auto &[section, keys] : old.m_sections) {
+    for (const auto &[key, value] : keys) {
+      auto iter = m_index.find(INIKeyView{section, key});
+      if (iter != m_index.end() && iter->second.layer == index)
+        resolve_(INIKeyView{section, key});
+    }
+  }
+
+  for (const auto &[section, keys] : m_layers[index].m_sections) {
+    for (const auto &[key, value] : keys) {
+      auto iter = m_index.find(INIKeyView{section, key});
+      if (iter == m_index.end())
+        m_index.emplace(INIKey{section, key}, Entry{&value, index});
+      else if (iter->second.layer <= index)
+        iter->second = Entry{&value, index};
+    }
+  }
+}
+
+const std::string &INILayeredObject::get(std::string_view section,
+                                         std::string_view key) const {
+  auto iter = m_index.find(INIKeyView{section, key});
+  if (iter == m_index.end())
+    throw std::logic_error("Invalid Keyword");
+  return *iter->second.value;
+}
+
+const std::string *
+INILayeredObject::find(std::string_view section,
+                       std::string_view key) const noexcept {
+  auto iter = m_index.find(INIKeyView{section, key});
+  if (iter == m_index.end())
+    return nullptr;
+  return iter->second.value;
+}
+
+bool INILayeredObject::contains(std::string_view section,
+                                std::string_view key) const noexcept {
+  return m_index.find(INIKeyView{section, key}) != m_index.end();
+}
+
+std::size_t INILayeredObject::sourceLayer(std::string_view section,
+                                          std::string_view key) const {
+  auto iter = m_index.find(INIKeyView{section, key});
+  if (iter == m_index.end())
+    throw std::logic_error("Invalid Keyword");
+  return iter->second.layer;
+}
+
+const INIObject &INILayeredObject::layer(std::size_t index) const {
+  if (index >= m_layers.size())
+    throw std::logic_error("Invalid Layer Index");
+  return m_layers[index];
+}
+
+std::size_t INILayeredObject::layerCount() const noexcept {
+  return m_layers.size();
+}
+
+INIObject INILayeredObject::merged() const {
+  INIObject localObject;
+  for (const auto &[name, entry] : m_index) {
+    localObject.m_sections[name.section][name.key] = *entry.value;
+  }
+  return localObject;
+}
+
+void INILayeredObject::resolve_(INIKeyView key) {
+  for (std::size_t i = m_layers.size(); i-- > 0;) {
+    const auto &sections = m_layers[i].m_sections;
+    auto sectionIter = sections.find(std::string(key.section));
+    if (sectionIter == sections.end())
+      continue;
+    auto keyIter = sectionIter->second.find(std::string(key.key));
+    if (keyIter == sectionIter->second.end())
+      continue;
+    m_index.find(key)->second = Entry{&keyIter->second, i};
+    return;
+  }
+  m_index.erase(m_index.find(key));
+}
+
+// INIInterpolatedObject
+
+INIInterpolatedObject::INIInterpolatedObject(const INIObject &ob) {
+  ob.materialize_();
+  for (const auto &[section, keys] : ob.m_sections) {
+    for (const auto &[key, value] : keys) {
+      auto iter = m_ids.emplace(INIKey{section, key}, m_nodes.size()).first;
+      Node &node = m_nodes.emplace_back();
+      node.name = &iter->first;
+      node.raw = value;
+    }
+  }
+
+  for (std::size_t id = 0; id < m_nodes.size(); id++) {
+    const INIKey &name = *m_nodes[id].name;
+    link_(id, compile_(m_nodes[id].raw, {name.section, name.key}, id));
+  }
+  for (std::size_t id = 0; id < m_nodes.size(); id++)
+    resolve_(id);
+}
+
+const std::string &INIInterpolatedObject::get(std::string_view section,
+                                              std::string_view key) const {
+  return node_(section, key).value;
+}
+
+const std::string &INIInterpolatedObject::raw(std::string_view section,
+                                              std::string_view key) const {
+  return node_(section, key).raw;
+}
+
+bool INIInterpolatedObject::contains(std::string_view section,
+                                     std::string_view key) const noexcept {
+  return m_ids.find(INIKeyView{section, key}) != m_ids.end();
+}
+
+void INIInterpolatedObject::set(std::string_view section, std::string_view key,
+                                std::string value) {
+  auto iter = m_ids.find(INIKeyView{section, key});
+  const bool exists = iter != m_ids.end();
+  const std::size_t id = exists ? iter->second : m_nodes.size();
+
+  std::vector<Part> parts = compile_(value, {section, key}, id);
+
+  // Refuse the change if any new dependency already depends on this key.
+  std::vector<std::size_t> pending;
+  for (const auto &part : parts) {
+    if (part.kind == Part::Reference)
+      pending.push_back(part.ref);
+  }
+  std::vector<bool> seen(m_nodes.size() + 1);
+  while (!pending.empty()) {
+    std::size_t current = pending.back();
+    pending.pop_back();
+    if (current == id)
+      throw std::logic_error("Interpolation cycle detected at [" +
+                             std::string(section) + "] " + std::string(key));
+    if (seen[current])
+      continue;
+    seen[current] = true;
+    for (std::size_t dependency : m_nodes[current].dependencies)
+      pending.push_back(dependency);
+  }
+
+  if (!exists) {
+    iter = m_ids.emplace(INIKey{std::string(section), std::string(key)}, id)
+               .first;
+    m_nodes.emplace_back().name = &iter->first;
+  }
+  m_nodes[id].raw = std::move(value);
+  link_(id, std::move(parts));
+
+  std::vector<std::size_t> affected{id};
+  m_nodes[id].state = 0;
+  for (std::size_t i = 0; i < affected.size(); i++) {
+    for (std::size_t dependent : m_nodes[affected[i]].dependents) {
+      if (m_nodes[dependent].state != 0) {
+        m_nodes[dependent].state = 0;
+        affected.push_back(dependent);
+      }
+    }
+  }
+  for (std::size_t current : affected)
+    resolve_(current);
+}
+
+INIObject INIInterpolatedObject::resolved() const {
+  INIObject localObject;
+  for (const auto &node : m_nodes)
+    localObject.m_sections[node.name->section][node.name->key] = node.value;
+  return localObject;
+}
+
+std::vector<INIInterpolatedObject::Part>
+INIInterpolatedObject::compile_(std::string_view raw, INIKeyView self,
+                                std::size_t selfId) const {
+  std::vector<Part> parts;
+  auto appendLiteral = [&](std::string_view text) {
+    if (text.empty())
+      return;
+    if (parts.empty() || parts.back().kind != Part::Literal)
+      parts.push_back({Part::Literal, {}});
+    parts.back().text += text;
+  };
+
+  std::size_t pos = 0;
+  while (pos < raw.size()) {
+    std::size_t dollar = raw.find('$', pos);
+    if (dollar == std::string_view::npos || dollar + 1 == raw.size()) {
+      appendLiteral(raw.substr(pos));
+      break;
+    }
+    appendLiteral(raw.substr(pos, dollar - pos));
+    if (raw[dollar + 1] == '$') {
+      appendLiteral("$");
+      pos = dollar + 2;
+      continue;
+    }
+    if (raw[dollar + 1] != '{') {
+      appendLiteral("$");
+      pos = dollar + 1;
+      continue;
+    }
+
+    std::size_t close = raw.find('}', dollar + 2);
+    if (close == std::string_view::npos)
+      throw std::logic_error("Unterminated interpolation in [" +
+                             std::string(self.section) + "] " +
+                             std::string(self.key));
+    std::string_view reference = raw.substr(dollar + 2, close - dollar - 2);
+    std::size_t colon = reference.find(':');
+    if (colon == std::string_view::npos) {
+      parts.push_back({Part::Environment, std::string(reference)});
+    } else {
+      INIKeyView target{reference.substr(0, colon),
+                        reference.substr(colon + 1)};
+      std::size_t ref = selfId;
+      if (!INIKeyEqual{}(target, self)) {
+        auto iter = m_ids.find(target);
+        if (iter == m_ids.end())
+          throw std::logic_error("Invalid interpolation reference ${" +
+                                 std::string(reference) + "} in [" +
+                                 std::string(self.section) + "] " +
+                                 std::string(self.key));
+        ref = iter->second;
+      }
+      parts.push_back({Part::Reference, {}, ref});
+    }
+    pos = close + 1;
+  }
+  return parts;
+}
+
+void INIInterpolatedObject::link_(std::size_t id, std::vector<Part> parts) {
+  for (std::size_t dependency : m_nodes[id].dependencies) {
+    auto &dependents = m_nodes[dependency].dependents;
+    dependents.erase(std::find(dependents.begin(), dependents.end(), id));
+  }
+  m_nodes[id].dependencies.clear();
+
+  for (const auto &part : parts) {
+    if (part.kind != Part::Reference)
+      continue;
+    auto &dependencies = m_nodes[id].dependencies;
+    if (std::find(dependencies.begin(), dependencies.end(), part.ref) !=
+        dependencies.end())
+      continue;
+    dependencies.push_back(part.ref);
+    m_nodes[part.ref].dependents.push_back(id);
+  }
+  m_nodes[id].parts = std::move(parts);
+}
+
+void INIInterpolatedObject::resolve_(std::size_t id) {
+  Node &node = m_nodes[id];
+  if (node.state == 2)
+    return;
+  if (node.state == 1)
+    throw std::logic_error("Interpolation cycle detected at [" +
+                           node.name->section + "] " + node.name->key);
+
+  node.state = 1;
+  for (std::size_t dependency : node.dependencies)
+    resolve_(dependency);
+
+  std::string value;
+  for (const auto &part : node.parts) {
+    switch (part.kind) {
+    case Part::Literal:
+      value += part.text;
+      break;
+    case Part::Reference:
+      value += m_nodes[part.ref].value;
+      break;
+    case Part::Environment:
+      if (const char *env = std::getenv(part.text.c_str()))
+        value += env;
+      break;
+    }
+  }
+  node.value = std::move(value);
+  node.state = 2;
+}
+
+const INIInterpolatedObject::Node &
+INIInterpolatedObject::node_(std::string_view section,
+                             std::string_view key) const {
+  auto iter = m_ids.find(INIKeyView{section, key});
+  if (iter == m_ids.end())
+    throw std::logic_error("Invalid Keyword");
+  return m_nodes[iter->second];
+}
+
 INI_NAMESPACE_END
@@ -1,15 +1,73 @@
 #ifndef INI_HPP
 #define INI_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
+
+namespace qjson {
+class JObject;
+} // namespace qjson
 
 namespace qini {
 class INIParser;
 class INIWriter;
+class INILayeredObject;
+class INIInterpolatedObject;
+class INISnapshot;
+struct INIDiff;
+
+/**
+ * @brief Owning (section, key) pair used as a flat lookup key.
+ */
+struct INIKey {
+  std::string section;
+  std::string key;
+};
+
+/**
+ * @brief Non-owning (section, key) pair used for allocation-free lookups.
+ */
+struct INIKeyView {
+  std::string_view section;
+  std::string_view key;
+};
+
+struct INIKeyHash {
+  using hash_type = std::hash<std::string_view>;
+  using is_transparent = void;
+
+  std::size_t operator()(INIKeyView key) const noexcept {
+    std::size_t seed = hash_type{}(key.section);
+    return seed ^ (hash_type{}(key.key) +
+                   static_cast<std::size_t>(0x9e3779b97f4a7c15ULL) +
+                   (seed << 6) + (seed >> 2));
+  }
+  std::size_t operator()(const INIKey &key) const noexcept {
+    return operator()(INIKeyView{key.section, key.key});
+  }
+};
+
+struct INIKeyEqual {
+  using is_transparent = void;
+
+  template <class A, class B>
+  bool operator()(const A &a, const B &b) const noexcept {
+    return a.section == b.section && a.key == b.key;
+  }
+};
 
 /**
  * @brief Class representing an INI object.
@@ -191,11 +249,127 @@ public:
   friend bool operator!=(const INIObject &ia, const INIObject &ib);
 
 private:
-  std::unordered_map<std::string, std::unordered_map<std::string, std::string>>
+  using keys_t = std::unordered_map<std::string, std::string>;
+
+  struct LazySections;
+
+  // What diff() knows about one section's content hash.
+  struct SectionHash {
+    std::size_t value = 0;
+    bool known = false;
+    // A mutable Section was handed out, so a reference into the keys may
+    // still be written through; the hash is never trusted again.
+    bool exposed = false;
+  };
+
+  std::optional<std::size_t> sectionHash_(const keys_t &keys) const;
+
+  // Parse the pending body of one section, or of every section, of an
+  // object returned by INIParser::lazyParse(). No-ops otherwise.
+  void materialize_(const std::string &sectionName) const;
+  void materialize_() const;
+  void parsePending_(const std::string &sectionName) const;
+
+  // Mutable so that lazily parsed sections can be filled in by const
+  // accessors; every lazily indexed section has its (empty) entry from the
+  // start, so this never inserts into the outer map.
+  mutable std::unordered_map<std::string,
+                             std::unordered_map<std::string, std::string>>
       m_sections;
+  std::shared_ptr<LazySections> m_lazy;
+
+  // Content hashes of sections, keyed by the address of their key map.
+  // Mutable access marks a section exposed, without locking, like any other
+  // write; m_hashMutex only serializes diff() calls filling in hashes.
+  mutable std::unordered_map<const keys_t *, SectionHash> m_sectionHashes;
+  mutable std::mutex m_hashMutex;
 
   friend class INIParser;
   friend class INIWriter;
+  friend class INILayeredObject;
+  friend class INIInterpolatedObject;
+  friend class INISnapshot;
+  friend qjson::JObject to_jobject(const INIObject &ob, bool inferTypes);
+  friend qjson::JObject to_jobject(INIObject &&ob, bool inferTypes);
+  friend INIObject to_iniobject(const qjson::JObject &jobject);
+  friend INIDiff diff(const INIObject &from, const INIObject &to);
+  friend void patch(INIObject &ob, const INIDiff &changes);
+};
+
+/**
+ * @brief Structure describing the changes between two INI objects.
+ */
+struct INIDiff {
+  /**
+   * @brief Changes inside a section present on both sides.
+   */
+  struct SectionDiff {
+    std::unordered_map<std::string, std::string> added;
+    std::unordered_map<std::string, std::string> changed; ///< New values.
+    std::vector<std::string> removed;
+  };
+
+  std::unordered_map<std::string, std::unordered_map<std::string, std::string>>
+      addedSections;
+  std::vector<std::string> removedSections;
+  std::unordered_map<std::string, SectionDiff> changedSections;
+
+  bool empty() const noexcept;
+};
+
+/**
+ * @brief Computes the changes turning one INI object into another.
+ *
+ * Each section's content hash is cached in its object, so a section whose
+ * hash matches on both sides is skipped in O(1); sections are then taken
+ * as equal on a 64-bit hash match. A section handed out through a
+ * non-const path (operator[], begin()) is never hashed again, since a
+ * reference kept from that access may still be written through; it is
+ * compared key by key instead. patch() keeps the cache up to date.
+ * @param from The original INI object.
+ * @param to The updated INI object.
+ * @return The added, removed and changed sections and keys.
+ */
+INIDiff diff(const INIObject &from, const INIObject &to);
+
+/**
+ * @brief Applies changes computed by diff() to an INI object.
+ * @param ob The INI object to update.
+ * @param changes The changes to apply.
+ */
+void patch(INIObject &ob, const INIDiff &changes);
+
+/**
+ * @brief What one INIParser::parse() call saw, for finding expensive inputs.
+ *
+ * Everything but the settings is reset at the start of each parse.
+ */
+struct INIParseStats {
+  /// Time per phase; phases other than total are measured only with
+  /// timePhases. Blank skipping makes up the rest of total.
+  struct Times {
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds headers{}; ///< Section names.
+    std::chrono::nanoseconds keys{};
+    std::chrono::nanoseconds values{};
+  };
+
+  std::size_t bytes = 0; ///< Input consumed.
+  std::size_t lines = 0;
+  std::size_t sections = 0;    ///< Section headers, repeated ones included.
+  std::size_t keys = 0;        ///< Key/value pairs read.
+  std::size_t overwrites = 0;  ///< Pairs that replaced an earlier value.
+  std::size_t keyBytes = 0;    ///< Characters of all keys read.
+  std::size_t valueBytes = 0;  ///< Characters of all values read.
+  std::size_t maxValueLength = 0;
+  Times time;
+  bool failed = false; ///< The parse threw; counts stop where it did.
+
+  // Settings, kept across parses.
+  /// Time each token; adds two clock reads per header, key and value.
+  bool timePhases = false;
+  /// Called at the end of every parse, failed ones included.
+  std::function<void(const INIParseStats &)> tracer;
 };
 
 /**
@@ -213,6 +387,31 @@ public:
    */
   INIObject parse(std::string_view data);
 
+  /**
+   * @brief Parses INI data and records what it contained.
+   *
+   * The statistics come from an instrumentation policy that parse(data)
+   * replaces with empty hooks, so the plain overload pays nothing for it.
+   * @param data The INI data to parse.
+   * @param stats Receives the statistics; its tracer, if any, is called.
+   * @return The parsed INI object.
+   */
+  INIObject parse(std::string_view data, INIParseStats &stats);
+
+  /**
+   * @brief Parses INI data in a given dialect.
+   *
+   * The input is read line by line; each line is blank, a `;`/`#`
+   * comment, a `[section]` header or a `key=value` pair with optional
+   * blanks around `=`. Extensions are selected by the dialect's flags
+   * (see INIDialect) and compiled out when disabled, so parse() keeps its
+   * speed whatever dialects are in use.
+   * @tparam Dialect The dialect, e.g. INIExtendedDialect.
+   * @param data The INI data to parse.
+   * @return The parsed INI object.
+   */
+  template <class Dialect> INIObject parse(std::string_view data);
+
   /**
    * @brief Quickly parses INI data from a string view.
    * @param data The INI data to parse.
@@ -227,16 +426,394 @@ public:
    */
   static INIObject fastParse(std::ifstream &infile);
 
+  /**
+   * @brief Parses INI data on several threads.
+   *
+   * The buffer is split at section headers (lines starting with '[') and
+   * each chunk is parsed into its own object on a separate thread. The
+   * chunks are then merged in input order, so a section appearing in
+   * several chunks gets the union of their keys and a repeated key keeps
+   * its last value, exactly as with parse().
+   * @param data The INI data to parse.
+   * @param threadCount The number of threads, or 0 for the hardware
+   * concurrency. Small inputs are parsed serially.
+   * @return The parsed INI object.
+   */
+  INIObject parallelParse(std::string_view data, std::size_t threadCount = 0);
+
+  /**
+   * @brief Parses INI data lazily, one section at a time.
+   *
+   * Only the section headers are located up front. The body of a section
+   * is parsed the first time INIObject::operator[] asks for it, so the cost
+   * is proportional to the sections actually read. Any other access
+   * (iteration, comparison, copying, writing, conversion) parses all
+   * remaining sections first. A syntax error inside a section is thrown by
+   * the access that parses it. Const access from several threads is safe.
+   * @param data The INI data to parse. The object keeps it until every
+   * section has been parsed.
+   * @return The parsed INI object.
+   */
+  INIObject lazyParse(std::string data);
+
+  /**
+   * @brief Parses an INI file, following include directives.
+   *
+   * A line of the form `@include path` or `@import path` merges the named
+   * file at that point; relative paths are resolved against the directory
+   * of the including file. Each included file is parsed once per process
+   * and reused until it (or anything it includes) changes on disk.
+   * Include cycles throw std::logic_error.
+   * @param path The path of the file to parse.
+   * @return The parsed INI object.
+   */
+  INIObject parseFile(const std::filesystem::path &path);
+
+  /**
+   * @brief Drops every cached include parsed by parseFile().
+   */
+  static void clearIncludeCache();
+
 protected:
+  struct IncludeContext;
+
+  void parse_(std::string_view data, INIObject &localObject,
+              long long error_line, IncludeContext *context = nullptr);
+  template <class Instrument>
+  void parse_(std::string_view data, INIObject &localObject,
+              long long error_line, IncludeContext *context,
+              Instrument &instrument);
+
+  void include_(std::string_view directive, INIObject &localObject,
+                IncludeContext &context, long long error_line);
+
+  static std::vector<std::size_t> splitSections_(std::string_view data,
+                                                 std::size_t chunkCount);
+
+  friend class INIObject;
+
+  template <class Dialect>
+  void dialectLine_(std::string_view line, INIObject &localObject,
+                    std::unordered_map<std::string, std::string> *&keys,
+                    long long error_line);
+
+  template <class Dialect>
+  std::string dialectValue_(std::string_view line, std::size_t &i,
+                            long long error_line);
+
   bool skipSpace(std::string_view::iterator &i, std::string_view data,
                  long long &error_line);
 
   std::string getString(std::string_view::iterator &i, std::string_view data,
                         long long error_line);
 
+  void endLine(std::string_view::iterator &i, std::string_view data,
+               long long error_line);
+
   std::string getLogicErrorString(long long error_line);
 };
 
+/**
+ * @brief Compile-time INI dialect for INIParser::parse<Dialect>().
+ *
+ * Any type with the same static constexpr members can be used instead.
+ * @tparam CRLF Accept `\r\n` line ends.
+ * @tparam SpacesInValues Unquoted values run to the end of the line or to
+ * a `;`/`#` following a blank, with trailing blanks removed.
+ * @tparam QuotedValues Accept `"..."` and `'...'` values.
+ * @tparam EscapeSequences Decode `\n`, `\t`, `\r`, `\0`, `\\`, `\"`,
+ * `\'`, `\;`, `\#`, `\=` and `\ ` in unquoted and double-quoted values.
+ * @tparam LineContinuation A line ending in an unescaped `\` is joined
+ * with the next one, whose leading blanks are dropped.
+ * @tparam Strict Reject duplicate keys and unknown escape sequences
+ * instead of keeping the last value and the escape as written.
+ */
+template <bool CRLF, bool SpacesInValues, bool QuotedValues,
+          bool EscapeSequences, bool LineContinuation, bool Strict = false>
+struct INIDialect {
+  static constexpr bool crlf = CRLF;
+  static constexpr bool spacesInValues = SpacesInValues;
+  static constexpr bool quotedValues = QuotedValues;
+  static constexpr bool escapeSequences = EscapeSequences;
+  static constexpr bool lineContinuation = LineContinuation;
+  static constexpr bool strict = Strict;
+};
+
+/// `key=value` tokens, like INIParser::parse(), except that blanks around
+/// `=` are accepted, where parse() rejects `key = value`.
+using INIBasicDialect = INIDialect<false, false, false, false, false>;
+/// Files written on Windows: CRLF, values with spaces, quoted values.
+using INIWindowsDialect = INIDialect<true, true, true, false, false>;
+/// Every extension: adds escape sequences and line continuations.
+using INIExtendedDialect = INIDialect<true, true, true, true, true>;
+/// INIExtendedDialect rejecting duplicate keys and unknown escapes.
+using INIStrictDialect = INIDialect<true, true, true, true, true, true>;
+
+template <class Dialect> INIObject INIParser::parse(std::string_view data) {
+  INIObject localObject;
+  std::unordered_map<std::string, std::string> *keys = nullptr;
+  std::string joined;
+  long long error_line = 0;
+  std::size_t pos = 0;
+
+  auto nextLine = [&] {
+    std::size_t end = data.find('\n', pos);
+    if (end == std::string_view::npos)
+      end = data.size();
+    std::string_view line = data.substr(pos, end - pos);
+    pos = end + 1;
+    if constexpr (Dialect::crlf) {
+      if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    }
+    return line;
+  };
+  [[maybe_unused]] auto continues = [](std::string_view line) {
+    std::size_t count = 0;
+    while (count < line.size() && line[line.size() - 1 - count] == '\\')
+      count++;
+    return Dialect::escapeSequences ? count % 2 == 1 : count > 0;
+  };
+
+  while (pos < data.size()) {
+    std::string_view line = nextLine();
+    const long long line_number = ++error_line;
+    if constexpr (Dialect::lineContinuation) {
+      if (continues(line)) {
+        joined.assign(line.substr(0, line.size() - 1));
+        while (pos < data.size()) {
+          std::string_view next = nextLine();
+          error_line++;
+          next.remove_prefix(
+              std::min(next.find_first_not_of(" \t"), next.size()));
+          if (!continues(next)) {
+            joined += next;
+            break;
+          }
+          joined += next.substr(0, next.size() - 1);
+        }
+        line = joined;
+      }
+    }
+    dialectLine_<Dialect>(line, localObject, keys, line_number);
+  }
+  return localObject;
+}
+
+template <class Dialect>
+void INIParser::dialectLine_(
+    std::string_view line, INIObject &localObject,
+    std::unordered_map<std::string, std::string> *&keys,
+    long long error_line) {
+  auto isBlank = [](char c) {
+    return c == ' ' || c == '\t' || (Dialect::crlf && c == '\r');
+  };
+  auto isDelimiter = [&](char c) {
+    return isBlank(c) || c == '[' || c == ']' || c == '=' || c == ';';
+  };
+  std::size_t i = 0;
+  auto skipBlank = [&] {
+    while (i < line.size() && isBlank(line[i]))
+      i++;
+  };
+  auto getName = [&] {
+    std::size_t start = i;
+    while (i < line.size() && !isDelimiter(line[i]))
+      i++;
+    return line.substr(start, i - start);
+  };
+  auto expectEnd = [&] {
+    skipBlank();
+    if (i < line.size() && line[i] != ';' && line[i] != '#')
+      throw std::logic_error(getLogicErrorString(error_line));
+  };
+
+  skipBlank();
+  if (i == line.size() || line[i] == ';' || line[i] == '#')
+    return;
+
+  if (line[i] == '[') {
+    i++;
+    skipBlank();
+    std::string_view section = getName();
+    skipBlank();
+    if (section.empty() || i == line.size() || line[i] != ']')
+      throw std::logic_error(getLogicErrorString(error_line));
+    i++;
+    expectEnd();
+    keys = &localObject.m_sections[std::string(section)];
+    return;
+  }
+
+  if (keys == nullptr || line[i] == '=')
+    throw std::logic_error(getLogicErrorString(error_line));
+  std::string_view key = getName();
+  skipBlank();
+  if (i == line.size() || line[i] != '=')
+    throw std::logic_error(getLogicErrorString(error_line));
+  i++;
+  skipBlank();
+  std::string value = dialectValue_<Dialect>(line, i, error_line);
+  expectEnd();
+
+  if constexpr (Dialect::strict) {
+    if (!keys->try_emplace(std::string(key), std::move(value)).second)
+      throw std::logic_error(getLogicErrorString(error_line));
+  } else {
+    (*keys)[std::string(key)] = std::move(value);
+  }
+}
+
+template <class Dialect>
+std::string INIParser::dialectValue_(std::string_view line, std::size_t &i,
+                                     long long error_line) {
+  auto isBlank = [](char c) {
+    return c == ' ' || c == '\t' || (Dialect::crlf && c == '\r');
+  };
+  std::string value;
+  [[maybe_unused]] auto escape = [&] {
+    if (i == line.size())
+      throw std::logic_error(getLogicErrorString(error_line));
+    const char c = line[i++];
+    switch (c) {
+    case 'n': value += '\n'; break;
+    case 't': value += '\t'; break;
+    case 'r': value += '\r'; break;
+    case '0': value += '\0'; break;
+    case '\\': case '"': case '\'': case ';': case '#': case '=': case ' ':
+      value += c;
+      break;
+    default:
+      if constexpr (Dialect::strict)
+        throw std::logic_error(getLogicErrorString(error_line));
+      value += '\\';
+      value += c;
+    }
+  };
+
+  if constexpr (Dialect::quotedValues) {
+    if (i < line.size() && (line[i] == '"' || line[i] == '\'')) {
+      const char quote = line[i++];
+      for (;;) {
+        if (i == line.size())
+          throw std::logic_error(getLogicErrorString(error_line));
+        const char c = line[i++];
+        if (c == quote)
+          return value;
+        if constexpr (Dialect::escapeSequences) {
+          if (c == '\\' && quote == '"') {
+            escape();
+            continue;
+          }
+        }
+        value += c;
+      }
+    }
+  }
+
+  // Unquoted. `kept` is the length without trailing blanks; escaped
+  // blanks count as content.
+  const std::size_t start = i;
+  std::size_t kept = 0;
+  while (i < line.size()) {
+    const char c = line[i];
+    if constexpr (Dialect::spacesInValues) {
+      if ((c == ';' || c == '#') && (i == start || isBlank(line[i - 1])))
+        break;
+    } else {
+      if (isBlank(c) || c == '[' || c == ']' || c == '=' || c == ';')
+        break;
+    }
+    i++;
+    if constexpr (Dialect::escapeSequences) {
+      if (c == '\\') {
+        escape();
+        kept = value.size();
+        continue;
+      }
+    }
+    value += c;
+    if (!isBlank(c))
+      kept = value.size();
+  }
+  value.resize(kept);
+  return value;
+}
+
+/**
+ * @brief Class reading INI data as a stream of (section, key, value) events.
+ *
+ * Input is consumed in fixed-size chunks and never materialized as an
+ * INIObject, so memory stays bounded by the chunk size plus the longest
+ * line. The reader is line-oriented: each line is blank, a `;`/`#`
+ * comment, a `[section]` header or a `key=value` pair, with optional
+ * blanks around `=`. Lines may span chunk boundaries.
+ */
+class INIReader {
+public:
+  /**
+   * @brief Receives one key. The views are only valid during the call.
+   * @return false to stop reading, true to continue.
+   */
+  using callback_t = std::function<bool(
+      std::string_view section, std::string_view key, std::string_view value)>;
+
+  explicit INIReader(std::size_t chunkSize = 64 * 1024);
+  ~INIReader() = default;
+
+  /**
+   * @brief Reads a file descriptor to its end.
+   *
+   * Starts from a fresh state, and leaves the reader reset when it
+   * returns or throws, so it can be reused for the next input.
+   * @param fd The file descriptor to read from.
+   * @param callback The event callback.
+   * @return false if the callback stopped the scan, true otherwise.
+   */
+  bool read(int fd, const callback_t &callback);
+
+  /**
+   * @brief Reads an input stream to its end.
+   *
+   * Starts from a fresh state, and leaves the reader reset when it
+   * returns or throws, so it can be reused for the next input.
+   * @param input The input stream to read from.
+   * @param callback The event callback.
+   * @return false if the callback stopped the scan, true otherwise.
+   */
+  bool read(std::istream &input, const callback_t &callback);
+
+  /**
+   * @brief Pushes the next piece of input.
+   * @param chunk The data, which may end in the middle of a line.
+   * @param callback The event callback.
+   * @return false if the callback stopped the scan, true otherwise.
+   */
+  bool feed(std::string_view chunk, const callback_t &callback);
+
+  /**
+   * @brief Processes the last, unterminated line and resets the reader.
+   * @param callback The event callback.
+   * @return false if the callback stopped the scan, true otherwise.
+   */
+  bool finish(const callback_t &callback);
+
+  void reset();
+
+protected:
+  bool line_(std::string_view line, const callback_t &callback);
+
+  std::string getLogicErrorString() const;
+
+private:
+  std::size_t m_chunkSize;
+  std::vector<char> m_chunk;
+  std::string m_partial; ///< Start of a line split across chunks.
+  std::string m_section;
+  long long m_line = 0;
+  bool m_stopped = false;
+};
+
 /**
  * @brief Class for writing INI data.
  */
@@ -275,6 +852,168 @@ public:
    */
   static bool fastWrite(const INIObject &ob, std::ofstream &file);
 };
+
+/**
+ * @brief Class stacking several INI objects with precedence.
+ *
+ * Layers added later override earlier ones (e.g. base, environment, host,
+ * overrides). All layers are folded into one flat index, so a lookup is a
+ * single hash probe however many layers are stacked.
+ */
+class INILayeredObject {
+public:
+  INILayeredObject() = default;
+  ~INILayeredObject() = default;
+
+  INILayeredObject(const INILayeredObject &) = delete;
+  INILayeredObject(INILayeredObject &&) noexcept = default;
+
+  INILayeredObject &operator=(const INILayeredObject &) = delete;
+  INILayeredObject &operator=(INILayeredObject &&) noexcept = default;
+
+  /**
+   * @brief Pushes a layer on top of the stack.
+   * @param layer The INI object to add.
+   * @return The index of the new layer.
+   */
+  std::size_t addLayer(INIObject layer);
+
+  /**
+   * @brief Replaces a layer, rebuilding only the entries it touches.
+   * @param index The index of the layer to replace.
+   * @param layer The new content of the layer.
+   */
+  void reloadLayer(std::size_t index, INIObject layer);
+
+  /**
+   * @brief Gets the effective value of a key.
+   * @param section The section name.
+   * @param key The key name.
+   * @return The value from the highest layer defining the key.
+   */
+  const std::string &get(std::string_view section, std::string_view key) const;
+
+  /**
+   * @brief Gets the effective value of a key, if any.
+   * @return A pointer to the value, or nullptr if no layer defines the key.
+   */
+  const std::string *find(std::string_view section,
+                          std::string_view key) const noexcept;
+
+  bool contains(std::string_view section, std::string_view key) const noexcept;
+
+  /**
+   * @brief Gets the index of the layer providing the effective value.
+   */
+  std::size_t sourceLayer(std::string_view section,
+                          std::string_view key) const;
+
+  const INIObject &layer(std::size_t index) const;
+
+  std::size_t layerCount() const noexcept;
+
+  /**
+   * @brief Flattens all layers into a single INI object.
+   * @return The merged INI object.
+   */
+  INIObject merged() const;
+
+private:
+  struct Entry {
+    const std::string *value;
+    std::size_t layer;
+  };
+
+  void resolve_(INIKeyView key);
+
+  // Entries point into the layers' nodes; these stay put when the vector
+  // reallocates because INIObject moves its map without reallocating.
+  std::vector<INIObject> m_layers;
+  std::unordered_map<INIKey, Entry, INIKeyHash, INIKeyEqual> m_index;
+};
+
+/**
+ * @brief Class resolving `${section:key}` and `${ENV}` references in values.
+ *
+ * All references are resolved once, with cycle detection, and the results
+ * are memoized, so get() is a plain lookup. set() recomputes only the key
+ * it changes and the values depending on it. `$$` stands for a literal `$`.
+ * Environment variables are read when a value referencing them is computed.
+ */
+class INIInterpolatedObject {
+public:
+  INIInterpolatedObject() = default;
+  ~INIInterpolatedObject() = default;
+
+  /**
+   * @brief Resolves every value of an INI object.
+   * @param ob The INI object holding the raw values.
+   * @throw std::logic_error on an unknown reference or a reference cycle.
+   */
+  explicit INIInterpolatedObject(const INIObject &ob);
+
+  INIInterpolatedObject(const INIInterpolatedObject &) = delete;
+  INIInterpolatedObject(INIInterpolatedObject &&) noexcept = default;
+
+  INIInterpolatedObject &operator=(const INIInterpolatedObject &) = delete;
+  INIInterpolatedObject &operator=(INIInterpolatedObject &&) noexcept = default;
+
+  /**
+   * @brief Gets the resolved value of a key.
+   */
+  const std::string &get(std::string_view section, std::string_view key) const;
+
+  /**
+   * @brief Gets the value of a key as written, before interpolation.
+   */
+  const std::string &raw(std::string_view section, std::string_view key) const;
+
+  bool contains(std::string_view section, std::string_view key) const noexcept;
+
+  /**
+   * @brief Sets the raw value of a key and recomputes its dependents.
+   *
+   * On an unknown reference or a cycle, std::logic_error is thrown and the
+   * object is left unchanged.
+   * @param section The section name.
+   * @param key The key name.
+   * @param value The new raw value.
+   */
+  void set(std::string_view section, std::string_view key, std::string value);
+
+  /**
+   * @brief Builds an INI object holding the resolved values.
+   * @return The resolved INI object.
+   */
+  INIObject resolved() const;
+
+private:
+  struct Part {
+    enum Kind : std::uint8_t { Literal, Reference, Environment };
+    Kind kind;
+    std::string text;      ///< Literal text or environment variable name.
+    std::size_t ref = 0;   ///< Referenced node for Kind::Reference.
+  };
+
+  struct Node {
+    const INIKey *name = nullptr;
+    std::string raw;
+    std::string value;
+    std::vector<Part> parts;
+    std::vector<std::size_t> dependencies;
+    std::vector<std::size_t> dependents;
+    std::uint8_t state = 0; ///< 0 stale, 1 resolving, 2 resolved.
+  };
+
+  std::vector<Part> compile_(std::string_view raw, INIKeyView self,
+                             std::size_t selfId) const;
+  void link_(std::size_t id, std::vector<Part> parts);
+  void resolve_(std::size_t id);
+  const Node &node_(std::string_view section, std::string_view key) const;
+
+  std::vector<Node> m_nodes;
+  std::unordered_map<INIKey, std::size_t, INIKeyHash, INIKeyEqual> m_ids;
+};
 } // namespace qini
 
 #endif // !INI_HPP
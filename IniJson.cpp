@@ -0,0 +1,156 @@
+#include "IniJson.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#define INI_NAMESPACE_START namespace qini {
+#define INI_NAMESPACE_END }
+
+INI_NAMESPACE_START
+
+namespace {
+qjson::JObject toValue(const std::string &value, bool inferTypes) {
+  if (!inferTypes || value.empty())
+    return qjson::JObject(std::string_view(value));
+
+  if (value == "true")
+    return qjson::JObject(true);
+  if (value == "false")
+    return qjson::JObject(false);
+
+  const char *first = value.data();
+  const char *last = first + value.size();
+  // "007" is an identifier or a code more often than a number; reading it
+  // as 7 would lose the zeros.
+  const char *lead = first + (*first == '-');
+  if (last - lead > 1 && *lead == '0' && lead[1] >= '0' && lead[1] <= '9')
+    return qjson::JObject(std::string_view(value));
+
+  // An exponent is accepted so that doubles written by to_iniobject()
+  // read back as doubles.
+  std::size_t digits = 0;
+  std::size_t exponentDigits = 0;
+  bool isDouble = false;
+  bool exponent = false;
+  for (const char *i = lead; i != last; i++) {
+    if (*i >= '0' && *i <= '9') {
+      (exponent ? exponentDigits : digits)++;
+    } else if (*i == '.' && !isDouble) {
+      isDouble = true;
+    } else if ((*i == 'e' || *i == 'E') && digits != 0 && !exponent) {
+      isDouble = exponent = true;
+      if (i + 1 != last && (i[1] == '-' || i[1] == '+'))
+        i++;
+    } else {
+      return qjson::JObject(std::string_view(value));
+    }
+  }
+  if (digits == 0 || (exponent && exponentDigits == 0))
+    return qjson::JObject(std::string_view(value));
+
+  if (isDouble) {
+    qjson::double_t number = 0;
+    auto result = std::from_chars(first, last, number);
+    if (result.ec == std::errc() && result.ptr == last)
+      return qjson::JObject(number);
+  } else {
+    qjson::int_t number = 0;
+    auto result = std::from_chars(first, last, number);
+    if (result.ec == std::errc() && result.ptr == last)
+      return qjson::JObject(number);
+  }
+  return qjson::JObject(std::string_view(value));
+}
+
+qjson::JObject
+toSection(const std::unordered_map<std::string, std::string> &keys,
+          bool inferTypes) {
+  qjson::JObject localJO(qjson::JDict);
+  auto &dict = localJO.getDict();
+  dict.reserve(keys.size());
+  for (const auto &[key, value] : keys) {
+    dict.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                 std::forward_as_tuple(toValue(value, inferTypes)));
+  }
+  return localJO;
+}
+
+std::string toText(const qjson::JObject &jobject) {
+  switch (jobject.getType()) {
+  case qjson::JNull:
+    return {};
+  case qjson::JInt:
+    return std::to_string(jobject.getInt());
+  case qjson::JDouble: {
+    // Shortest text that reads back as the same value; std::to_string
+    // would round to six decimals.
+    char buffer[64];
+    auto result =
+        std::to_chars(buffer, buffer + sizeof(buffer), jobject.getDouble());
+    return {buffer, result.ptr};
+  }
+  case qjson::JBool:
+    return jobject.getBool() ? "true" : "false";
+  case qjson::JString: {
+    const auto &str = jobject.getPMRString();
+    return {str.begin(), str.end()};
+  }
+  default:
+    return qjson::to_string(jobject);
+  }
+}
+} // namespace
+
+qjson::JObject to_jobject(const INIObject &ob, bool inferTypes) {
+  qjson::JObject localJO(qjson::JDict);
+  auto &dict = localJO.getDict();
+  ob.materialize_();
+  dict.reserve(ob.m_sections.size());
+  for (const auto &[section, keys] : ob.m_sections) {
+    dict.emplace(std::piecewise_construct, std::forward_as_tuple(section),
+                 std::forward_as_tuple(toSection(keys, inferTypes)));
+  }
+  return localJO;
+}
+
+qjson::JObject to_jobject(INIObject &&ob, bool inferTypes) {
+  qjson::JObject localJO(qjson::JDict);
+  auto &dict = localJO.getDict();
+  ob.materialize_();
+  ob.m_sectionHashes.clear();
+  auto &sections = ob.m_sections;
+  dict.reserve(sections.size());
+  while (!sections.empty()) {
+    auto node = sections.extract(sections.begin());
+    dict.emplace(std::piecewise_construct, std::forward_as_tuple(node.key()),
+                 std::forward_as_tuple(toSection(node.mapped(), inferTypes)));
+  }
+  return localJO;
+}
+
+INIObject to_iniobject(const qjson::JObject &jobject) {
+  INIObject localObject;
+  const auto &dict = jobject.getDict();
+  localObject.m_sections.reserve(dict.size());
+  for (const auto &[section, members] : dict) {
+    const auto &memberDict = members.getDict();
+    auto &keys =
+        localObject.m_sections
+            .emplace(std::piecewise_construct,
+                     std::forward_as_tuple(section.begin(), section.end()),
+                     std::forward_as_tuple())
+            .first->second;
+    keys.reserve(memberDict.size());
+    for (const auto &[key, value] : memberDict) {
+      keys.emplace(std::piecewise_construct,
+                   std::forward_as_tuple(key.begin(), key.end()),
+                   std::forward_as_tuple(toText(value)));
+    }
+  }
+  return localObject;
+}
+
+INI_NAMESPACE_END
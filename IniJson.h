@@ -0,0 +1,39 @@
+#ifndef INI_JSON_HPP
+#define INI_JSON_HPP
+
+#include "Ini.h"
+#include "Json.h"
+
+namespace qini {
+/**
+ * @brief Converts an INI object into a JSON dict of section dicts.
+ * @param ob The INI object to convert.
+ * @param inferTypes Whether to turn `true`/`false`, integers and decimals
+ * into JBool, JInt and JDouble values instead of JString. Numbers with
+ * leading zeros, such as `007`, stay strings.
+ * @return The JSON object.
+ */
+qjson::JObject to_jobject(const INIObject &ob, bool inferTypes = false);
+
+/**
+ * @brief Converts an INI object into a JSON dict of section dicts,
+ * releasing each section of the source as soon as it is converted.
+ * @param ob The INI object to convert; it is left empty.
+ * @param inferTypes Whether to infer JBool, JInt and JDouble values.
+ * @return The JSON object.
+ */
+qjson::JObject to_jobject(INIObject &&ob, bool inferTypes = false);
+
+/**
+ * @brief Converts a JSON dict of section dicts into an INI object.
+ *
+ * Scalars are written as their text (null as an empty string, doubles in
+ * the shortest form that reads back exactly); nested lists and dicts are
+ * written as compact JSON.
+ * @param jobject The JSON object to convert.
+ * @return The INI object.
+ */
+INIObject to_iniobject(const qjson::JObject &jobject);
+} // namespace qini
+
+#endif // !INI_JSON_HPP
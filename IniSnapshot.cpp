@@ -0,0 +1,470 @@
+#include "IniSnapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define INI_NAMESPACE_START namespace qini {
+#define INI_NAMESPACE_END }
+
+INI_NAMESPACE_START
+
+namespace {
+constexpr char snapshot_magic[8] = {'Q', 'I', 'N', 'I', 'S', 'N', 'A', 'P'};
+constexpr std::uint32_t snapshot_version = 1;
+constexpr std::uint32_t empty_slot = 0xFFFFFFFFu;
+constexpr std::uint32_t max_displacement = 1u << 20;
+
+std::uint64_t mix(std::uint64_t x) noexcept {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+std::uint64_t hashBytes(const char *data, std::size_t size,
+                        std::uint64_t seed) noexcept {
+  std::uint64_t h = mix(seed ^ (size * 0x9e3779b97f4a7c15ULL));
+  for (; size >= 8; data += 8, size -= 8) {
+    std::uint64_t k;
+    std::memcpy(&k, data, 8);
+    h = mix(h ^ k);
+  }
+  if (size != 0) {
+    std::uint64_t k = 0;
+    std::memcpy(&k, data, size);
+    h = mix(h ^ k ^ (static_cast<std::uint64_t>(size) << 56));
+  }
+  return h;
+}
+
+std::uint64_t hashKey(std::string_view section, std::string_view key,
+                      std::uint64_t seed) noexcept {
+  return hashBytes(key.data(), key.size(),
+                   hashBytes(section.data(), section.size(), seed));
+}
+
+std::uint32_t slotOf(std::uint64_t hash, std::uint32_t displacement,
+                     std::uint32_t slotCount) noexcept {
+  return static_cast<std::uint32_t>(
+      mix(hash + displacement * 0x9e3779b97f4a7c15ULL) % slotCount);
+}
+
+std::size_t alignUp(std::size_t size) { return (size + 7) & ~std::size_t(7); }
+
+std::string readFile(const std::filesystem::path &path) {
+  std::ifstream infile(path, std::ios_base::binary);
+  if (!infile)
+    throw std::logic_error("Cannot open file: " + path.string());
+  infile.seekg(0, std::ios_base::end);
+  std::size_t size = infile.tellg();
+  infile.seekg(0, std::ios_base::beg);
+  std::string buffer;
+  buffer.resize(size);
+  infile.read(buffer.data(), size);
+  return buffer;
+}
+
+void writeFileAtomically(const std::filesystem::path &path,
+                         std::string_view data) {
+  std::filesystem::path temporary = path;
+  temporary += ".tmp" + std::to_string(std::random_device{}());
+  {
+    std::ofstream outfile(temporary, std::ios_base::binary);
+    if (!outfile)
+      throw std::logic_error("Cannot write file: " + temporary.string());
+    outfile.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!outfile)
+      throw std::logic_error("Cannot write file: " + temporary.string());
+  }
+  // Readers either see the old snapshot or the complete new one.
+  std::filesystem::rename(temporary, path);
+}
+
+template <class T> T load(const char *data) noexcept {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+} // namespace
+
+INISnapshot::~INISnapshot() { close(); }
+
+INISnapshot::INISnapshot(INISnapshot &&snapshot) noexcept
+    : m_data(std::exchange(snapshot.m_data, nullptr)),
+      m_size(std::exchange(snapshot.m_size, 0)), m_header(snapshot.m_header)
+#ifdef _WIN32
+      ,
+      m_file(std::exchange(snapshot.m_file, nullptr)),
+      m_mapping(std::exchange(snapshot.m_mapping, nullptr))
+#endif
+{
+}
+
+INISnapshot &INISnapshot::operator=(INISnapshot &&snapshot) noexcept {
+  if (this == &snapshot)
+    return *this;
+
+  close();
+  m_data = std::exchange(snapshot.m_data, nullptr);
+  m_size = std::exchange(snapshot.m_size, 0);
+  m_header = snapshot.m_header;
+#ifdef _WIN32
+  m_file = std::exchange(snapshot.m_file, nullptr);
+  m_mapping = std::exchange(snapshot.m_mapping, nullptr);
+#endif
+  return *this;
+}
+
+std::string INISnapshot::compile(const INIObject &ob, std::uint64_t sourceHash,
+                                 std::uint64_t sourceSize) {
+  struct Source {
+    const std::string *section;
+    const std::string *key;
+    const std::string *value;
+  };
+
+  ob.materialize_();
+  std::vector<Source> sources;
+  for (const auto &[section, keys] : ob.m_sections) {
+    for (const auto &[key, value] : keys)
+      sources.push_back({&section, &key, &value});
+  }
+  std::sort(sources.begin(), sources.end(),
+            [](const Source &a, const Source &b) {
+              int order = a.section->compare(*b.section);
+              return order != 0 ? order < 0 : *a.key < *b.key;
+            });
+  if (sources.size() >= empty_slot)
+    throw std::logic_error("Too many keys for a snapshot");
+
+  // Sorted string table; each section name is stored once.
+  std::string strings;
+  std::vector<Entry> entries(sources.size());
+  auto append = [&strings](const std::string &text) {
+    if (strings.size() + text.size() > empty_slot)
+      throw std::logic_error("Too much data for a snapshot");
+    auto offset = static_cast<std::uint32_t>(strings.size());
+    strings += text;
+    return offset;
+  };
+  for (std::size_t i = 0; i < sources.size(); i++) {
+    Entry &entry = entries[i];
+    if (i != 0 && *sources[i - 1].section == *sources[i].section) {
+      entry.section = entries[i - 1].section;
+    } else {
+      entry.section = append(*sources[i].section);
+    }
+    entry.sectionSize = static_cast<std::uint32_t>(sources[i].section->size());
+    entry.key = append(*sources[i].key);
+    entry.keySize = static_cast<std::uint32_t>(sources[i].key->size());
+    entry.value = append(*sources[i].value);
+    entry.valueSize = static_cast<std::uint32_t>(sources[i].value->size());
+  }
+
+  // Hash-and-displace perfect hashing: place the largest buckets first,
+  // trying displacements until every key of a bucket lands in a free slot.
+  const auto entryCount = static_cast<std::uint32_t>(entries.size());
+  const std::uint32_t bucketCount = entryCount / 4 + 1;
+  const std::uint32_t slotCount = entryCount + entryCount / 4 + 1;
+  std::vector<std::uint32_t> displacements(bucketCount);
+  std::vector<std::uint32_t> slots(slotCount);
+  std::uint64_t seed = 0;
+
+  for (bool placed = false; !placed; seed++) {
+    std::vector<std::uint64_t> hashes(entryCount);
+    std::vector<std::vector<std::uint32_t>> buckets(bucketCount);
+    for (std::uint32_t i = 0; i < entryCount; i++) {
+      hashes[i] = hashKey(*sources[i].section, *sources[i].key, seed);
+      buckets[hashes[i] % bucketCount].push_back(i);
+    }
+    std::vector<std::uint32_t> order(bucketCount);
+    for (std::uint32_t b = 0; b < bucketCount; b++)
+      order[b] = b;
+    std::sort(order.begin(), order.end(),
+              [&](std::uint32_t a, std::uint32_t b) {
+                return buckets[a].size() > buckets[b].size();
+              });
+
+    std::fill(slots.begin(), slots.end(), empty_slot);
+    std::fill(displacements.begin(), displacements.end(), 0);
+    std::vector<std::uint32_t> chosen;
+    placed = true;
+    for (std::uint32_t b : order) {
+      const auto &members = buckets[b];
+      if (members.empty())
+        break;
+
+      std::uint32_t displacement = 0;
+      for (; displacement < max_displacement; displacement++) {
+        chosen.clear();
+        for (std::uint32_t member : members) {
+          std::uint32_t slot = slotOf(hashes[member], displacement, slotCount);
+          if (slots[slot] != empty_slot ||
+              std::find(chosen.begin(), chosen.end(), slot) != chosen.end())
+            break;
+          chosen.push_back(slot);
+        }
+        if (chosen.size() == members.size())
+          break;
+      }
+      if (displacement == max_displacement) {
+        placed = false;
+        break;
+      }
+      displacements[b] = displacement;
+      for (std::size_t m = 0; m < members.size(); m++)
+        slots[chosen[m]] = members[m];
+    }
+  }
+  seed--;
+
+  Header header{};
+  std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+  header.version = snapshot_version;
+  header.entryCount = entryCount;
+  header.bucketCount = bucketCount;
+  header.slotCount = slotCount;
+  header.seed = seed;
+  header.sourceHash = sourceHash;
+  header.sourceSize = sourceSize;
+  header.entriesOffset = alignUp(sizeof(Header));
+  header.bucketsOffset =
+      alignUp(header.entriesOffset + entries.size() * sizeof(Entry));
+  header.slotsOffset =
+      alignUp(header.bucketsOffset + bucketCount * sizeof(std::uint32_t));
+  header.stringsOffset =
+      alignUp(header.slotsOffset + slotCount * sizeof(std::uint32_t));
+  header.stringsSize = strings.size();
+
+  std::string image(header.stringsOffset + strings.size(), '\0');
+  std::memcpy(image.data(), &header, sizeof(Header));
+  if (!entries.empty())
+    std::memcpy(image.data() + header.entriesOffset, entries.data(),
+                entries.size() * sizeof(Entry));
+  std::memcpy(image.data() + header.bucketsOffset, displacements.data(),
+              bucketCount * sizeof(std::uint32_t));
+  std::memcpy(image.data() + header.slotsOffset, slots.data(),
+              slotCount * sizeof(std::uint32_t));
+  std::copy(strings.begin(), strings.end(),
+            image.begin() + static_cast<std::ptrdiff_t>(header.stringsOffset));
+  return image;
+}
+
+void INISnapshot::compileFile(const std::filesystem::path &source,
+                              const std::filesystem::path &snapshot) {
+  std::string buffer = readFile(source);
+  writeFileAtomically(snapshot, compile(INIParser::fastParse(buffer),
+                                        hashSource(buffer), buffer.size()));
+}
+
+INISnapshot INISnapshot::openOrCompile(const std::filesystem::path &source,
+                                       const std::filesystem::path &snapshot) {
+  std::string buffer = readFile(source);
+
+  INISnapshot localSnapshot;
+  if (localSnapshot.open(snapshot) && localSnapshot.matchesSource(buffer))
+    return localSnapshot;
+
+  localSnapshot.close();
+  writeFileAtomically(snapshot, compile(INIParser::fastParse(buffer),
+                                        hashSource(buffer), buffer.size()));
+  if (!localSnapshot.open(snapshot))
+    throw std::logic_error("Cannot open snapshot: " + snapshot.string());
+  return localSnapshot;
+}
+
+std::uint64_t INISnapshot::hashSource(std::string_view data) noexcept {
+  return hashBytes(data.data(), data.size(), 0);
+}
+
+bool INISnapshot::open(const std::filesystem::path &snapshot) {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileW(snapshot.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) ||
+      static_cast<std::uint64_t>(fileSize.QuadPart) < sizeof(Header)) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+  const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  m_file = file;
+  m_mapping = mapping;
+  m_data = static_cast<const char *>(view);
+  m_size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+  int fd = ::open(snapshot.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat info{};
+  if (::fstat(fd, &info) != 0 ||
+      static_cast<std::uint64_t>(info.st_size) < sizeof(Header)) {
+    ::close(fd);
+    return false;
+  }
+  void *view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                      PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED)
+    return false;
+  m_data = static_cast<const char *>(view);
+  m_size = static_cast<std::size_t>(info.st_size);
+#endif
+
+  std::memcpy(&m_header, m_data, sizeof(Header));
+  const Header &header = m_header;
+  const std::uint64_t size = m_size;
+  auto fits = [size](std::uint64_t offset, std::uint64_t count,
+                     std::uint64_t width) {
+    return offset <= size && count <= (size - offset) / width;
+  };
+  bool valid =
+      std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) == 0 &&
+      header.version == snapshot_version && header.bucketCount != 0 &&
+      header.slotCount != 0 &&
+      fits(header.entriesOffset, header.entryCount, sizeof(Entry)) &&
+      fits(header.bucketsOffset, header.bucketCount, sizeof(std::uint32_t)) &&
+      fits(header.slotsOffset, header.slotCount, sizeof(std::uint32_t)) &&
+      fits(header.stringsOffset, header.stringsSize, 1);
+  if (!valid) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void INISnapshot::close() noexcept {
+  if (m_data == nullptr)
+    return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_mapping);
+  CloseHandle(m_file);
+  m_mapping = nullptr;
+  m_file = nullptr;
+#else
+  ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+  m_data = nullptr;
+  m_size = 0;
+  m_header = {};
+}
+
+bool INISnapshot::isOpen() const noexcept { return m_data != nullptr; }
+
+bool INISnapshot::matchesSource(std::string_view sourceData) const noexcept {
+  return m_data != nullptr && m_header.sourceSize == sourceData.size() &&
+         m_header.sourceHash == hashSource(sourceData);
+}
+
+bool INISnapshot::isFresh(const std::filesystem::path &source) const {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(source, ec);
+  if (ec || m_data == nullptr || size != m_header.sourceSize)
+    return false;
+  return matchesSource(readFile(source));
+}
+
+std::optional<std::string_view>
+INISnapshot::find(std::string_view section,
+                  std::string_view key) const noexcept {
+  if (m_data == nullptr)
+    return std::nullopt;
+
+  std::uint64_t hash = hashKey(section, key, m_header.seed);
+  auto displacement = load<std::uint32_t>(
+      m_data + m_header.bucketsOffset +
+      (hash % m_header.bucketCount) * sizeof(std::uint32_t));
+  auto index = load<std::uint32_t>(
+      m_data + m_header.slotsOffset +
+      slotOf(hash, displacement, m_header.slotCount) * sizeof(std::uint32_t));
+  if (index >= m_header.entryCount)
+    return std::nullopt;
+
+  Entry entry = entry_(index);
+  if (string_(entry.section, entry.sectionSize) != section ||
+      string_(entry.key, entry.keySize) != key)
+    return std::nullopt;
+  return string_(entry.value, entry.valueSize);
+}
+
+std::string_view INISnapshot::get(std::string_view section,
+                                  std::string_view key) const {
+  auto value = find(section, key);
+  if (!value)
+    throw std::logic_error("Invalid Keyword");
+  return *value;
+}
+
+INISnapshot::Item INISnapshot::at(std::size_t index) const {
+  if (index >= size())
+    throw std::logic_error("Invalid Index");
+  Entry entry = entry_(index);
+  return {string_(entry.section, entry.sectionSize),
+          string_(entry.key, entry.keySize),
+          string_(entry.value, entry.valueSize)};
+}
+
+std::size_t INISnapshot::size() const noexcept {
+  return m_data == nullptr ? 0 : m_header.entryCount;
+}
+
+INIObject INISnapshot::toObject() const {
+  INIObject localObject;
+  for (std::size_t i = 0; i < size(); i++) {
+    Item item = at(i);
+    localObject.m_sections[std::string(item.section)][std::string(item.key)] =
+        item.value;
+  }
+  return localObject;
+}
+
+INISnapshot::Entry INISnapshot::entry_(std::size_t index) const noexcept {
+  return load<Entry>(m_data + m_header.entriesOffset + index * sizeof(Entry));
+}
+
+std::string_view INISnapshot::string_(std::uint32_t offset,
+                                      std::uint32_t size) const noexcept {
+  // Out-of-range references in a corrupt file read as empty strings.
+  if (offset > m_header.stringsSize || size > m_header.stringsSize - offset)
+    return {};
+  return {m_data + m_header.stringsOffset + offset, size};
+}
+
+INI_NAMESPACE_END
@@ -0,0 +1,163 @@
+#ifndef INI_SNAPSHOT_HPP
+#define INI_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Ini.h"
+
+namespace qini {
+/**
+ * @brief Class giving read-only access to a compiled INI snapshot.
+ *
+ * A snapshot is a flat binary image of an INI object: a table of entries
+ * sorted by (section, key) pointing into a string table, plus a perfect
+ * hash index over the entries. It is memory-mapped and queried in place,
+ * so opening it costs no parsing and no allocation. Snapshots record the
+ * size and hash of the text they were compiled from and use the native
+ * byte order of the machine that wrote them.
+ */
+class INISnapshot {
+public:
+  /**
+   * @brief A (section, key, value) triple stored in a snapshot.
+   */
+  struct Item {
+    std::string_view section;
+    std::string_view key;
+    std::string_view value;
+  };
+
+  INISnapshot() = default;
+  ~INISnapshot();
+
+  INISnapshot(const INISnapshot &) = delete;
+  INISnapshot(INISnapshot &&snapshot) noexcept;
+
+  INISnapshot &operator=(const INISnapshot &) = delete;
+  INISnapshot &operator=(INISnapshot &&snapshot) noexcept;
+
+  /**
+   * @brief Serializes an INI object into a snapshot image.
+   * @param ob The INI object to serialize.
+   * @param sourceHash The hashSource() value of the text \p ob came from.
+   * @param sourceSize The size of that text.
+   * @return The snapshot bytes.
+   */
+  static std::string compile(const INIObject &ob, std::uint64_t sourceHash = 0,
+                             std::uint64_t sourceSize = 0);
+
+  /**
+   * @brief Parses an INI file and writes its snapshot.
+   * @param source The INI file.
+   * @param snapshot The snapshot file to (re)write.
+   */
+  static void compileFile(const std::filesystem::path &source,
+                          const std::filesystem::path &snapshot);
+
+  /**
+   * @brief Opens a snapshot, recompiling it first if it is missing, invalid
+   * or older than the source text.
+   * @param source The INI file.
+   * @param snapshot The snapshot file.
+   * @return The opened snapshot.
+   */
+  static INISnapshot openOrCompile(const std::filesystem::path &source,
+                                   const std::filesystem::path &snapshot);
+
+  /**
+   * @brief Hashes INI source text for staleness checks.
+   */
+  static std::uint64_t hashSource(std::string_view data) noexcept;
+
+  /**
+   * @brief Maps a snapshot file into memory.
+   * @param snapshot The snapshot file.
+   * @return true if the file is a valid snapshot, false otherwise.
+   */
+  bool open(const std::filesystem::path &snapshot);
+
+  void close() noexcept;
+
+  bool isOpen() const noexcept;
+
+  /**
+   * @brief Checks whether the snapshot was compiled from the given text.
+   */
+  bool matchesSource(std::string_view sourceData) const noexcept;
+
+  /**
+   * @brief Checks whether the snapshot was compiled from the given file.
+   */
+  bool isFresh(const std::filesystem::path &source) const;
+
+  /**
+   * @brief Looks up a value in place.
+   * @return A view into the mapped snapshot, or std::nullopt.
+   */
+  std::optional<std::string_view> find(std::string_view section,
+                                       std::string_view key) const noexcept;
+
+  /**
+   * @brief Looks up a value in place.
+   * @return A view into the mapped snapshot.
+   */
+  std::string_view get(std::string_view section, std::string_view key) const;
+
+  /**
+   * @brief Gets the entry at a position in (section, key) order.
+   */
+  Item at(std::size_t index) const;
+
+  std::size_t size() const noexcept;
+
+  /**
+   * @brief Copies the snapshot back into an INI object.
+   * @return The INI object.
+   */
+  INIObject toObject() const;
+
+private:
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t bucketCount;
+    std::uint32_t slotCount;
+    std::uint64_t seed;
+    std::uint64_t sourceHash;
+    std::uint64_t sourceSize;
+    std::uint64_t entriesOffset;
+    std::uint64_t bucketsOffset;
+    std::uint64_t slotsOffset;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+  };
+
+  struct Entry {
+    std::uint32_t section;
+    std::uint32_t sectionSize;
+    std::uint32_t key;
+    std::uint32_t keySize;
+    std::uint32_t value;
+    std::uint32_t valueSize;
+  };
+
+  Entry entry_(std::size_t index) const noexcept;
+  std::string_view string_(std::uint32_t offset,
+                           std::uint32_t size) const noexcept;
+
+  const char *m_data = nullptr;
+  std::size_t m_size = 0;
+  Header m_header{};
+#ifdef _WIN32
+  void *m_file = nullptr;
+  void *m_mapping = nullptr;
+#endif
+};
+} // namespace qini
+
+#endif // !INI_SNAPSHOT_HPP
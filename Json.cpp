@@ -1,5 +1,7 @@
 #include "Json.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <memory_resource>
@@ -415,14 +417,197 @@ std::string to_string(const JObject &jobject, std::size_t indent) {
   return jwriter.formatWrite(jobject, indent);
 }
 
+namespace {
+// A dict entry is allocated as a node: the next pointer, the key/value pair
+// and the cached hash, which libstdc++ keeps because string_hash's
+// operator() is not noexcept.
+struct DictNode {
+  void *next;
+  dict_t::value_type value;
+  std::size_t hash;
+};
+constexpr std::size_t dict_node_size = sizeof(DictNode);
+
+void stringUsage(const string_t &str, JMemoryUsage &usage) {
+  // A default-constructed string reports its inline (SSO) capacity.
+  static const std::size_t inline_capacity = string_t().capacity();
+  if (str.capacity() <= inline_capacity) {
+    return;
+  }
+  usage.strings += str.size() + 1;
+  usage.slack += str.capacity() - str.size();
+}
+
+void memoryUsage(const JObject &jobject, JMemoryUsage &usage) {
+  ++usage.count;
+  switch (jobject.getType()) {
+  case JValueType::JString:
+    stringUsage(jobject.getPMRString(), usage);
+    break;
+  case JValueType::JList: {
+    const list_t &list = jobject.getList();
+    usage.nodes += list.size() * sizeof(JObject);
+    usage.slack += (list.capacity() - list.size()) * sizeof(JObject);
+    for (const auto &item : list) {
+      memoryUsage(item, usage);
+    }
+    break;
+  }
+  case JValueType::JDict: {
+    const dict_t &dict = jobject.getDict();
+    usage.nodes += dict.size() * dict_node_size;
+    // Single-bucket tables use storage inside the map object.
+    if (dict.bucket_count() > 1) {
+      usage.buckets += dict.bucket_count() * sizeof(void *);
+    }
+    for (const auto &[key, value] : dict) {
+      stringUsage(key, usage);
+      memoryUsage(value, usage);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+} // namespace
+
+JMemoryUsage memory_usage(const JObject &jobject) {
+  JMemoryUsage usage;
+  usage.nodes = sizeof(JObject);
+  memoryUsage(jobject, usage);
+  return usage;
+}
+
+namespace {
+/**
+ * @brief Instrumentation policy of the plain parse(): every hook only runs
+ * the token reader, and inlines away.
+ */
+struct NoInstrument {
+  struct Scope {};
+
+  Scope enter(JValueType) noexcept { return {}; }
+  template <class Read>
+  string_t string(bool, const std::size_t &, Read &&read) {
+    return read();
+  }
+  template <class Read> JObject number(Read &&read) { return read(); }
+  template <class Read> JObject literal(Read &&read) { return read(); }
+};
+
+/**
+ * @brief Instrumentation policy filling a JParseStats.
+ */
+class StatsInstrument {
+public:
+  explicit StatsInstrument(JParseStats &stats) : m_stats(stats) {}
+
+  /// Tracks the nesting depth until the container is closed or abandoned.
+  class Scope {
+  public:
+    explicit Scope(std::size_t &depth) : m_depth(depth) { ++m_depth; }
+    ~Scope() { --m_depth; }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    std::size_t &m_depth;
+  };
+
+  Scope enter(JValueType type) {
+    ++(type == JValueType::JDict ? m_stats.objects : m_stats.arrays);
+    m_stats.maxDepth = std::max(m_stats.maxDepth, m_depth + 1);
+    return Scope(m_depth);
+  }
+
+  template <class Read>
+  string_t string(bool isKey, const std::size_t &iter, Read &&read) {
+    const std::size_t start = iter;
+    string_t str = timed(m_stats.time.strings, read);
+    ++(isKey ? m_stats.keys : m_stats.strings);
+    // Every escape sequence is two characters decoded into one.
+    m_stats.escapes += iter - start - 2 - str.size();
+    return str;
+  }
+
+  template <class Read> JObject number(Read &&read) {
+    JObject number = timed(m_stats.time.numbers, read);
+    ++(number.getType() == JValueType::JInt ? m_stats.integers
+                                            : m_stats.doubles);
+    return number;
+  }
+
+  template <class Read> JObject literal(Read &&read) {
+    JObject literal = timed(m_stats.time.literals, read);
+    ++(literal.getType() == JValueType::JBool ? m_stats.bools
+                                              : m_stats.nulls);
+    return literal;
+  }
+
+private:
+  template <class Read>
+  auto timed(std::chrono::nanoseconds &total, Read &read) {
+    if (!m_stats.timePhases) {
+      return read();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto result = read();
+    total += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    return result;
+  }
+
+  JParseStats &m_stats;
+  std::size_t m_depth = 0;
+};
+} // namespace
+
 JObject JParser::parse(std::string_view string_data) {
   std::size_t iter = 0;
   std::string_view data = string_data;
   return parse_(data, data.size(), iter);
 }
 
+JObject JParser::parse(std::string_view data, JParseStats &stats) {
+  JParseStats fresh;
+  fresh.timePhases = stats.timePhases;
+  fresh.tracer = std::move(stats.tracer);
+  stats = std::move(fresh);
+
+  StatsInstrument instrument(stats);
+  const auto start = std::chrono::steady_clock::now();
+  std::size_t iter = 0;
+  auto finish = [&] {
+    stats.bytes = iter;
+    stats.time.total = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (stats.tracer) {
+      stats.tracer(stats);
+    }
+  };
+  JObject result;
+  try {
+    result = parse_(data, data.size(), iter, instrument);
+  } catch (...) {
+    stats.failed = true;
+    finish();
+    throw;
+  }
+  stats.memory = memory_usage(result);
+  finish();
+  return result;
+}
+
 JObject JParser::parse_(std::string_view data, std::size_t data_size,
                         std::size_t &iter) {
+  NoInstrument instrument;
+  return parse_(data, data_size, iter, instrument);
+}
+
+template <class Instrument>
+JObject JParser::parse_(std::string_view data, std::size_t data_size,
+                        std::size_t &iter, Instrument &instrument) {
   long long error_line = 0;
 
   if (data.empty()) {
@@ -435,13 +620,17 @@ JObject JParser::parse_(std::string_view data, std::size_t data_size,
 
   if (data[iter] == '{') {
     JObject localJO(JValueType::JDict);
+    [[maybe_unused]] const auto scope = instrument.enter(JValueType::JDict);
     ++iter;
     while (iter < data_size && data[iter] != '}') {
       skipSpace(data, data_size, iter, error_line);
       if (data[iter] == '}') {
+        ++iter;
         return localJO;
       }
-      std::pmr::string key(getString(data, data_size, iter, error_line));
+      std::pmr::string key(instrument.string(true, iter, [&] {
+        return getString(data, data_size, iter, error_line);
+      }));
       skipSpace(data, data_size, iter, error_line);
       if (data[iter] == ':') {
         ++iter;
@@ -449,7 +638,7 @@ JObject JParser::parse_(std::string_view data, std::size_t data_size,
         throw std::logic_error(getLogicErrorString(error_line));
       }
       skipSpace(data, data_size, iter, error_line);
-      localJO[key] = parse_(data, data_size, iter);
+      localJO[key] = parse_(data, data_size, iter, instrument);
       skipSpace(data, data_size, iter, error_line);
       if (data[iter] != ',' && data[iter] != '}') {
         throw std::logic_error(getLogicErrorString(error_line));
@@ -469,13 +658,15 @@ JObject JParser::parse_(std::string_view data, std::size_t data_size,
   }
   if (data[iter] == '[') {
     JObject localJO(JValueType::JList);
+    [[maybe_unused]] const auto scope = instrument.enter(JValueType::JList);
     ++iter;
     while (iter < data_size && data[iter] != ']') {
       skipSpace(data, data_size, iter, error_line);
       if (data[iter] == ']') {
+        ++iter;
         return localJO;
       }
-      localJO.push_back(parse_(data, data_size, iter));
+      localJO.push_back(parse_(data, data_size, iter, instrument));
       skipSpace(data, data_size, iter, error_line);
       if (data[iter] != ',' && data[iter] != ']') {
         throw std::logic_error(getLogicErrorString(error_line));
@@ -488,22 +679,28 @@ JObject JParser::parse_(std::string_view data, std::size_t data_size,
       skipSpace(data, data_size, iter, error_line);
     }
     if (data[iter] == ']') {
+      ++iter;
       return localJO;
     }
 
     throw std::logic_error(getLogicErrorString(error_line));
   }
   if (data[iter] == '\"') {
-    return getString(data, data_size, iter, error_line);
+    return instrument.string(false, iter, [&] {
+      return getString(data, data_size, iter, error_line);
+    });
   }
   if (data[iter] == 'n') {
-    return getNull(data, data_size, iter, error_line);
+    return instrument.literal(
+        [&] { return getNull(data, data_size, iter, error_line); });
   }
   if (data[iter] == 't' || data[iter] == 'f') {
-    return getBool(data, data_size, iter, error_line);
+    return instrument.literal(
+        [&] { return getBool(data, data_size, iter, error_line); });
   }
   if ((data[iter] >= '0' && data[iter] <= '9') || data[iter] == '-') {
-    return getNumber(data, data_size, iter, error_line);
+    return instrument.number(
+        [&] { return getNumber(data, data_size, iter, error_line); });
   }
   throw std::logic_error(getLogicErrorString(error_line));
 }
@@ -586,43 +783,76 @@ JObject JParser::getNumber(std::string_view data, std::size_t data_size,
          ((data[iter] >= '0' && data[iter] <= '9') || data[iter] == '.')) {
     if (!firstNum && data[iter] >= '0' && data[iter] <= '9') {
       firstNum = true;
-    } else if (isDouble) {
-      count++;
     } else if (data[iter] == '.') {
-      if (!firstNum) {
+      if (!firstNum || isDouble) {
         throw std::logic_error(getLogicErrorString(error_line));
       }
       isDouble = true;
       ++iter;
       continue;
+    } else if (isDouble) {
+      count++;
     }
     ++iter;
   }
+  if (!firstNum || (isDouble && count == 0)) {
+    throw std::logic_error(getLogicErrorString(error_line));
+  }
+  const std::size_t end = iter;
+
+  bool hasExponent = false;
+  long long exponent = 0;
+  if (iter < data_size && (data[iter] == 'e' || data[iter] == 'E')) {
+    hasExponent = true;
+    ++iter;
+    bool isNegativeExponent = false;
+    if (iter < data_size && (data[iter] == '+' || data[iter] == '-')) {
+      isNegativeExponent = data[iter] == '-';
+      ++iter;
+    }
+    if (iter >= data_size || data[iter] < '0' || data[iter] > '9') {
+      throw std::logic_error(getLogicErrorString(error_line));
+    }
+    while (iter < data_size && data[iter] >= '0' && data[iter] <= '9') {
+      // Anything this large is already 0 or inf; stop before overflowing.
+      if (exponent < 100000) {
+        exponent = exponent * 10 + (data[iter] - '0');
+      }
+      ++iter;
+    }
+    if (isNegativeExponent) {
+      exponent = -exponent;
+    }
+  }
 
   if (isDouble) {
-    double_t number = data[iter - 1] - '0';
-    std::size_t single = 10;
-    for (long long i = iter - 2; i >= static_cast<long long>(start);
-         --i, single *= 10) {
+    double_t number = data[end - 1] - '0';
+    double_t single = 10;
+    for (long long i = end - 2; i >= static_cast<long long>(start); --i) {
       if (data[i] == '.') {
         continue;
       }
       number += single * (data[i] - '0');
+      single *= 10;
     }
     if (isNegative) {
       number *= -1;
     }
-    return number / std::pow(10, count);
+    return number *
+           std::pow(10.0L, exponent - static_cast<long long>(count));
   }
-  long long number = data[iter - 1] - '0';
+  long long number = data[end - 1] - '0';
   std::size_t single = 10;
-  for (long long i = iter - 2; i >= static_cast<long long>(start);
+  for (long long i = end - 2; i >= static_cast<long long>(start);
        --i, single *= 10) {
     number += single * (data[i] - '0');
   }
   if (isNegative) {
     number *= -1;
   }
+  if (hasExponent) {
+    return static_cast<double_t>(number) * std::pow(10.0L, exponent);
+  }
   return number;
 }
 
@@ -631,12 +861,12 @@ JObject JParser::getBool(std::string_view data, std::size_t data_size,
   constexpr std::size_t true_size = 4;
   constexpr std::size_t false_size = 5;
   if (data_size >= iter + true_size &&
-      static_cast<bool>(std::memcmp(data.data(), "true", true_size))) {
+      std::memcmp(data.data() + iter, "true", true_size) == 0) {
     iter += 4;
     return true;
   }
   if (data_size >= iter + false_size &&
-      static_cast<bool>(std::memcmp(data.data(), "false", false_size))) {
+      std::memcmp(data.data() + iter, "false", false_size) == 0) {
     iter += false_size;
     return false;
   }
@@ -647,7 +877,7 @@ JObject JParser::getNull(std::string_view data, std::size_t data_size,
                          std::size_t &iter, long long error_line) {
   constexpr std::size_t null_size = 4;
   if (data_size >= iter + null_size &&
-      static_cast<bool>(std::memcmp(data.data(), "null", null_size))) {
+      std::memcmp(data.data() + iter, "null", null_size) == 0) {
     iter += null_size;
     return JObject();
   }
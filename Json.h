@@ -1,8 +1,10 @@
 #ifndef JSON_HPP
 #define JSON_HPP
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -120,6 +122,67 @@ JObject to_json(std::string_view data);
 std::string to_string(const JObject &jobject);
 std::string to_string(const JObject &jobject, std::size_t indent);
 
+/**
+ * @brief Memory held by a JObject tree, in bytes, by category.
+ *
+ * Container internals are estimated from their sizes and capacities with
+ * the common node layouts (libstdc++, libc++); allocator bookkeeping is
+ * not included.
+ */
+struct JMemoryUsage {
+  std::size_t nodes = 0;   ///< JObjects, and the dict entries holding them.
+  std::size_t strings = 0; ///< Out-of-line characters of keys and strings.
+  std::size_t buckets = 0; ///< Dict bucket arrays.
+  std::size_t slack = 0;   ///< Reserved, unused list and string capacity.
+  std::size_t count = 0;   ///< Number of JObjects.
+
+  std::size_t total() const noexcept {
+    return nodes + strings + buckets + slack;
+  }
+};
+
+/**
+ * @brief Measures the memory a JObject tree occupies, the root included.
+ */
+JMemoryUsage memory_usage(const JObject &jobject);
+
+/**
+ * @brief What one JParser::parse() call saw, for finding expensive inputs.
+ *
+ * Everything but the settings is reset at the start of each parse.
+ */
+struct JParseStats {
+  /// Time per phase; phases other than total are measured only with
+  /// timePhases. Structure and whitespace make up the rest of total.
+  struct Times {
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds strings{}; ///< Keys and string values.
+    std::chrono::nanoseconds numbers{};
+    std::chrono::nanoseconds literals{}; ///< true, false and null.
+  };
+
+  std::size_t bytes = 0; ///< Input consumed.
+  std::size_t objects = 0;
+  std::size_t arrays = 0;
+  std::size_t keys = 0;
+  std::size_t strings = 0; ///< String values, keys excluded.
+  std::size_t escapes = 0; ///< Escape sequences in keys and strings.
+  std::size_t integers = 0;
+  std::size_t doubles = 0;
+  std::size_t bools = 0;
+  std::size_t nulls = 0;
+  std::size_t maxDepth = 0; ///< Deepest container nesting.
+  Times time;
+  JMemoryUsage memory; ///< What the result holds; empty if parsing failed.
+  bool failed = false; ///< The parse threw; counts stop where it did.
+
+  // Settings, kept across parses.
+  /// Time each token; adds two clock reads per string, number or literal.
+  bool timePhases = false;
+  /// Called at the end of every parse, failed ones included.
+  std::function<void(const JParseStats &)> tracer;
+};
+
 /**
  * @brief Class for parsing JSON data.
  */
@@ -134,9 +197,25 @@ public:
    */
   JObject parse(std::string_view data);
 
+  /**
+   * @brief Parses JSON data and records what it contained.
+   *
+   * The statistics come from an instrumentation policy that parse(data)
+   * replaces with empty hooks, so the plain overload pays nothing for it.
+   * Collecting them costs a counter update per value and a walk of the
+   * result for JParseStats::memory.
+   * @param data The JSON data to parse.
+   * @param stats Receives the statistics; its tracer, if any, is called.
+   * @return The parsed JSON object.
+   */
+  JObject parse(std::string_view data, JParseStats &stats);
+
 protected:
   JObject parse_(std::string_view data, std::size_t data_size,
                  std::size_t &iter);
+  template <class Instrument>
+  JObject parse_(std::string_view data, std::size_t data_size,
+                 std::size_t &iter, Instrument &instrument);
   static void skipSpace(std::string_view data, std::size_t data_size,
                         std::size_t &iter, long long &error_line);
   static std::pmr::string getString(std::string_view data,
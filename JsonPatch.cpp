@@ -0,0 +1,634 @@
+#include "JsonPatch.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define JSON_NAMESPACE_START namespace qjson {
+#define JSON_NAMESPACE_END }
+
+JSON_NAMESPACE_START
+
+namespace {
+using Pointer = std::vector<std::string>;
+
+/// Like operator==, without copying strings to compare them.
+bool sameValue(const JObject &a, const JObject &b) {
+  if (&a == &b) {
+    return true;
+  }
+  if (a.getType() != b.getType()) {
+    return false;
+  }
+  switch (a.getType()) {
+  case JValueType::JNull:
+    return true;
+  case JValueType::JInt:
+    return a.getInt() == b.getInt();
+  case JValueType::JDouble:
+    return a.getDouble() == b.getDouble();
+  case JValueType::JBool:
+    return a.getBool() == b.getBool();
+  case JValueType::JString:
+    return a.getPMRString() == b.getPMRString();
+  case JValueType::JList: {
+    const list_t &la = a.getList();
+    const list_t &lb = b.getList();
+    return la.size() == lb.size() &&
+           std::equal(la.begin(), la.end(), lb.begin(), sameValue);
+  }
+  case JValueType::JDict: {
+    const dict_t &da = a.getDict();
+    const dict_t &db = b.getDict();
+    if (da.size() != db.size()) {
+      return false;
+    }
+    for (const auto &[key, value] : da) {
+      auto found = db.find(key);
+      if (found == db.end() || !sameValue(value, found->second)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  }
+  return false;
+}
+
+/// RFC 6902 "test" equality: sameValue, with numbers compared by value.
+bool testEqual(const JObject &a, const JObject &b) {
+  const bool aNumber =
+      a.getType() == JValueType::JInt || a.getType() == JValueType::JDouble;
+  const bool bNumber =
+      b.getType() == JValueType::JInt || b.getType() == JValueType::JDouble;
+  if (aNumber && bNumber && a.getType() != b.getType()) {
+    const double_t av = a.getType() == JValueType::JInt
+                            ? static_cast<double_t>(a.getInt())
+                            : a.getDouble();
+    const double_t bv = b.getType() == JValueType::JInt
+                            ? static_cast<double_t>(b.getInt())
+                            : b.getDouble();
+    return av == bv;
+  }
+  if (a.getType() != b.getType()) {
+    return false;
+  }
+  if (a.getType() == JValueType::JList) {
+    const list_t &la = a.getList();
+    const list_t &lb = b.getList();
+    return la.size() == lb.size() &&
+           std::equal(la.begin(), la.end(), lb.begin(), testEqual);
+  }
+  if (a.getType() == JValueType::JDict) {
+    const dict_t &da = a.getDict();
+    const dict_t &db = b.getDict();
+    if (da.size() != db.size()) {
+      return false;
+    }
+    for (const auto &[key, value] : da) {
+      auto found = db.find(key);
+      if (found == db.end() || !testEqual(value, found->second)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return sameValue(a, b);
+}
+
+// ---- diff ----
+
+void appendToken(std::string &path, std::string_view token) {
+  path += '/';
+  for (char c : token) {
+    if (c == '~') {
+      path += "~0";
+    } else if (c == '/') {
+      path += "~1";
+    } else {
+      path += c;
+    }
+  }
+}
+
+void addOperation(JObject &patch, std::string_view op,
+                  const std::string &path) {
+  JObject operation(JValueType::JDict);
+  operation["op"] = op;
+  operation["path"] = std::string_view(path);
+  patch.push_back(std::move(operation));
+}
+
+void addOperation(JObject &patch, std::string_view op,
+                  const std::string &path, const JObject &value) {
+  JObject operation(JValueType::JDict);
+  operation["op"] = op;
+  operation["path"] = std::string_view(path);
+  operation["value"] = value;
+  patch.push_back(std::move(operation));
+}
+
+void diffValue(const JObject &from, const JObject &to, std::string &path,
+               JObject &patch);
+
+void diffDict(const dict_t &from, const dict_t &to, std::string &path,
+              JObject &patch) {
+  const std::size_t length = path.size();
+  for (const auto &[key, value] : from) {
+    appendToken(path, key);
+    auto found = to.find(key);
+    if (found == to.end()) {
+      addOperation(patch, "remove", path);
+    } else {
+      diffValue(value, found->second, path, patch);
+    }
+    path.resize(length);
+  }
+  for (const auto &[key, value] : to) {
+    if (!from.contains(key)) {
+      appendToken(path, key);
+      addOperation(patch, "add", path, value);
+      path.resize(length);
+    }
+  }
+}
+
+void diffList(const list_t &from, const list_t &to, std::string &path,
+              JObject &patch) {
+  // Edits usually touch a few items, so the equal head and tail are
+  // skipped and only the middle is compared position by position.
+  std::size_t head = 0;
+  while (head < from.size() && head < to.size() &&
+         sameValue(from[head], to[head])) {
+    ++head;
+  }
+  std::size_t fromEnd = from.size();
+  std::size_t toEnd = to.size();
+  while (fromEnd > head && toEnd > head &&
+         sameValue(from[fromEnd - 1], to[toEnd - 1])) {
+    --fromEnd;
+    --toEnd;
+  }
+
+  const std::size_t length = path.size();
+  const std::size_t common = std::min(fromEnd - head, toEnd - head);
+  for (std::size_t i = head; i < head + common; i++) {
+    appendToken(path, std::to_string(i));
+    diffValue(from[i], to[i], path, patch);
+    path.resize(length);
+  }
+  // Removing at one index repeatedly drops the surplus items in order.
+  appendToken(path, std::to_string(head + common));
+  for (std::size_t i = head + common; i < fromEnd; i++) {
+    addOperation(patch, "remove", path);
+  }
+  path.resize(length);
+  for (std::size_t i = head + common; i < toEnd; i++) {
+    appendToken(path, std::to_string(i));
+    addOperation(patch, "add", path, to[i]);
+    path.resize(length);
+  }
+}
+
+void diffValue(const JObject &from, const JObject &to, std::string &path,
+               JObject &patch) {
+  if (&from == &to) {
+    return;
+  }
+  if (from.getType() == to.getType()) {
+    if (from.getType() == JValueType::JDict) {
+      diffDict(from.getDict(), to.getDict(), path, patch);
+      return;
+    }
+    if (from.getType() == JValueType::JList) {
+      diffList(from.getList(), to.getList(), path, patch);
+      return;
+    }
+    if (sameValue(from, to)) {
+      return;
+    }
+  }
+  addOperation(patch, "replace", path, to);
+}
+
+// ---- apply ----
+
+Pointer parsePointer(std::string_view text) {
+  Pointer pointer;
+  if (text.empty()) {
+    return pointer;
+  }
+  if (text[0] != '/') {
+    throw std::logic_error("Invalid Patch: bad pointer " + std::string(text));
+  }
+  std::string token;
+  for (std::size_t i = 1; i <= text.size(); i++) {
+    if (i == text.size() || text[i] == '/') {
+      pointer.push_back(std::move(token));
+      token.clear();
+    } else if (text[i] == '~') {
+      if (i + 1 == text.size() || (text[i + 1] != '0' && text[i + 1] != '1')) {
+        throw std::logic_error("Invalid Patch: bad pointer " +
+                               std::string(text));
+      }
+      token += text[++i] == '0' ? '~' : '/';
+    } else {
+      token += text[i];
+    }
+  }
+  return pointer;
+}
+
+std::string pointerString(const Pointer &pointer) {
+  std::string path;
+  for (const auto &token : pointer) {
+    appendToken(path, token);
+  }
+  return path;
+}
+
+[[noreturn]] void pathError(const Pointer &pointer) {
+  throw std::logic_error("Invalid Patch: no value at " +
+                         pointerString(pointer));
+}
+
+/// A list index token: digits without leading zeros, below `limit`.
+std::size_t listIndex(const std::string &token, std::size_t limit,
+                      const Pointer &pointer) {
+  std::size_t index = 0;
+  const char *first = token.data();
+  const char *last = first + token.size();
+  auto result = std::from_chars(first, last, index);
+  if (token.empty() || result.ec != std::errc() || result.ptr != last ||
+      (token.size() > 1 && token[0] == '0') || index > limit) {
+    pathError(pointer);
+  }
+  return index;
+}
+
+/// The container holding the value a pointer names; the pointer must not
+/// be empty.
+JObject &parentOf(JObject &document, const Pointer &pointer) {
+  JObject *current = &document;
+  for (std::size_t i = 0; i + 1 < pointer.size(); i++) {
+    const std::string &token = pointer[i];
+    if (current->getType() == JValueType::JDict) {
+      dict_t &dict = current->getDict();
+      auto found = dict.find(std::string_view(token));
+      if (found == dict.end()) {
+        pathError(pointer);
+      }
+      current = &found->second;
+    } else if (current->getType() == JValueType::JList) {
+      list_t &list = current->getList();
+      const std::size_t index = listIndex(token, list.size(), pointer);
+      if (index == list.size()) {
+        pathError(pointer);
+      }
+      current = &list[index];
+    } else {
+      pathError(pointer);
+    }
+  }
+  return *current;
+}
+
+JObject &valueAt(JObject &document, const Pointer &pointer) {
+  if (pointer.empty()) {
+    return document;
+  }
+  JObject &parent = parentOf(document, pointer);
+  if (parent.getType() == JValueType::JDict) {
+    dict_t &dict = parent.getDict();
+    auto found = dict.find(std::string_view(pointer.back()));
+    if (found == dict.end()) {
+      pathError(pointer);
+    }
+    return found->second;
+  }
+  if (parent.getType() == JValueType::JList) {
+    list_t &list = parent.getList();
+    const std::size_t index = listIndex(pointer.back(), list.size(), pointer);
+    if (index == list.size()) {
+      pathError(pointer);
+    }
+    return list[index];
+  }
+  pathError(pointer);
+}
+
+/**
+ * @brief How to take back one applied change.
+ *
+ * Values a change displaced are moved in here and moved back on undo, so
+ * keeping a patch atomic copies nothing.
+ */
+struct Undo {
+  enum Kind { Remove, Restore, Insert, Move };
+
+  Kind kind;
+  Pointer pointer;       ///< List positions are concrete, never "-".
+  Pointer from;          ///< Move: where the value came from.
+  JObject value;         ///< Restore, Insert, displaced Move: the value.
+  bool replaced = false; ///< Move: whether the value displaced another.
+};
+
+class Patcher {
+public:
+  explicit Patcher(JObject &document) : m_document(document) {}
+
+  /// RFC 6902 "add"; an existing dict member is replaced.
+  void add(Pointer pointer, JObject &value) {
+    std::optional<JObject> old = place_(pointer, value);
+    if (old) {
+      m_undo.push_back(
+          {Undo::Restore, std::move(pointer), {}, *std::move(old)});
+    } else {
+      m_undo.push_back({Undo::Remove, std::move(pointer), {}, {}});
+    }
+  }
+
+  /// RFC 6902 "remove".
+  void remove(Pointer pointer) {
+    if (pointer.empty()) {
+      throw std::logic_error("Invalid Patch: cannot remove the document");
+    }
+    JObject value = take_(pointer);
+    m_undo.push_back({Undo::Insert, std::move(pointer), {}, std::move(value)});
+  }
+
+  /// RFC 6902 "replace".
+  void replace(Pointer pointer, JObject &value) {
+    JObject &target = valueAt(m_document, pointer);
+    JObject old = std::exchange(target, std::move(value));
+    m_undo.push_back({Undo::Restore, std::move(pointer), {}, std::move(old)});
+  }
+
+  /// RFC 6902 "move": the subtree is relinked, never copied.
+  void move(Pointer from, Pointer to) {
+    if (from == to) {
+      valueAt(m_document, from);
+      return;
+    }
+    if (to.size() > from.size() &&
+        std::equal(from.begin(), from.end(), to.begin())) {
+      throw std::logic_error("Invalid Patch: cannot move " +
+                             pointerString(from) + " into itself");
+    }
+    JObject value = take_(from);
+    std::optional<JObject> old;
+    try {
+      old = place_(to, value);
+    } catch (...) {
+      place_(from, value);
+      throw;
+    }
+    Undo undo{Undo::Move, std::move(to), std::move(from), {}};
+    if (old) {
+      undo.value = *std::move(old);
+      undo.replaced = true;
+    }
+    m_undo.push_back(std::move(undo));
+  }
+
+  /// RFC 6902 "copy".
+  void copy(const Pointer &from, Pointer to) {
+    JObject value = valueAt(m_document, from);
+    add(std::move(to), value);
+  }
+
+  /// RFC 6902 "test".
+  void test(const Pointer &pointer, const JObject &value) {
+    if (!testEqual(valueAt(m_document, pointer), value)) {
+      throw std::logic_error("Invalid Patch: test failed at " +
+                             pointerString(pointer));
+    }
+  }
+
+  /// Takes back every change, newest first.
+  void rollback() {
+    for (auto undo = m_undo.rbegin(); undo != m_undo.rend(); ++undo) {
+      switch (undo->kind) {
+      case Undo::Remove:
+        take_(undo->pointer);
+        break;
+      case Undo::Restore:
+        valueAt(m_document, undo->pointer) = std::move(undo->value);
+        break;
+      case Undo::Insert:
+        place_(undo->pointer, undo->value);
+        break;
+      case Undo::Move: {
+        JObject value =
+            undo->replaced
+                ? std::exchange(valueAt(m_document, undo->pointer),
+                                std::move(undo->value))
+                : take_(undo->pointer);
+        place_(undo->from, value);
+        break;
+      }
+      }
+    }
+    m_undo.clear();
+  }
+
+private:
+  /**
+   * @brief Puts a value where "add" would.
+   *
+   * The value is moved from only once it is in place, and a "-" index is
+   * replaced by the position used.
+   * @return The value replaced, if any.
+   */
+  std::optional<JObject> place_(Pointer &pointer, JObject &value) {
+    if (pointer.empty()) {
+      return std::exchange(m_document, std::move(value));
+    }
+    JObject &parent = parentOf(m_document, pointer);
+    if (parent.getType() == JValueType::JDict) {
+      dict_t &dict = parent.getDict();
+      auto found = dict.find(std::string_view(pointer.back()));
+      if (found != dict.end()) {
+        return std::exchange(found->second, std::move(value));
+      }
+      dict.emplace(string_t(pointer.back()), std::move(value));
+      return std::nullopt;
+    }
+    if (parent.getType() == JValueType::JList) {
+      list_t &list = parent.getList();
+      const std::size_t index =
+          pointer.back() == "-"
+              ? list.size()
+              : listIndex(pointer.back(), list.size(), pointer);
+      list.insert(list.begin() + static_cast<std::ptrdiff_t>(index),
+                  std::move(value));
+      pointer.back() = std::to_string(index);
+      return std::nullopt;
+    }
+    pathError(pointer);
+  }
+
+  /// Detaches the value a pointer names.
+  JObject take_(const Pointer &pointer) {
+    JObject &parent = parentOf(m_document, pointer);
+    if (parent.getType() == JValueType::JDict) {
+      dict_t &dict = parent.getDict();
+      auto found = dict.find(std::string_view(pointer.back()));
+      if (found == dict.end()) {
+        pathError(pointer);
+      }
+      JObject value = std::move(found->second);
+      dict.erase(found);
+      return value;
+    }
+    if (parent.getType() == JValueType::JList) {
+      list_t &list = parent.getList();
+      const std::size_t index =
+          listIndex(pointer.back(), list.size(), pointer);
+      if (index == list.size()) {
+        pathError(pointer);
+      }
+      JObject value = std::move(list[index]);
+      list.erase(list.begin() + static_cast<std::ptrdiff_t>(index));
+      return value;
+    }
+    pathError(pointer);
+  }
+
+  JObject &m_document;
+  std::vector<Undo> m_undo;
+};
+
+const JObject *member(const JObject &operation, std::string_view key) {
+  const dict_t &dict = operation.getDict();
+  auto found = dict.find(key);
+  return found == dict.end() ? nullptr : &found->second;
+}
+
+const JObject &required(const JObject &operation, std::string_view key) {
+  const JObject *value = member(operation, key);
+  if (value == nullptr) {
+    throw std::logic_error("Invalid Patch: missing \"" + std::string(key) +
+                           "\"");
+  }
+  return *value;
+}
+
+Pointer requiredPointer(const JObject &operation, std::string_view key) {
+  const JObject &value = required(operation, key);
+  if (value.getType() != JValueType::JString) {
+    throw std::logic_error("Invalid Patch: \"" + std::string(key) +
+                           "\" is not a string");
+  }
+  return parsePointer(value.getPMRString());
+}
+
+/// The patch's copy of a value, or the value itself for a patch passed as
+/// an rvalue.
+template <typename Patch> JObject takeValue(Patch &value) {
+  if constexpr (std::is_const_v<Patch>) {
+    return value;
+  } else {
+    return std::move(value);
+  }
+}
+
+template <typename Patch> void applyPatch(JObject &document, Patch &patch) {
+  if (patch.getType() != JValueType::JList) {
+    throw std::logic_error("Invalid Patch: not a list of operations");
+  }
+  Patcher patcher(document);
+  try {
+    for (auto &operation : patch.getList()) {
+      if (operation.getType() != JValueType::JDict) {
+        throw std::logic_error("Invalid Patch: operation is not a dict");
+      }
+      const JObject &op = required(operation, "op");
+      if (op.getType() != JValueType::JString) {
+        throw std::logic_error("Invalid Patch: \"op\" is not a string");
+      }
+      const std::string_view name = op.getPMRString();
+      Pointer path = requiredPointer(operation, "path");
+      if (name == "add" || name == "replace" || name == "test") {
+        required(operation, "value");
+        auto &source = operation.getDict().find("value")->second;
+        if (name == "test") {
+          patcher.test(path, source);
+          continue;
+        }
+        JObject value = takeValue(source);
+        if (name == "add") {
+          patcher.add(std::move(path), value);
+        } else {
+          patcher.replace(std::move(path), value);
+        }
+      } else if (name == "remove") {
+        patcher.remove(std::move(path));
+      } else if (name == "move") {
+        patcher.move(requiredPointer(operation, "from"), std::move(path));
+      } else if (name == "copy") {
+        patcher.copy(requiredPointer(operation, "from"), std::move(path));
+      } else {
+        throw std::logic_error("Invalid Patch: unknown op \"" +
+                               std::string(name) + "\"");
+      }
+    }
+  } catch (...) {
+    patcher.rollback();
+    throw;
+  }
+}
+
+template <typename Patch> void mergePatch(JObject &target, Patch &patch) {
+  if (patch.getType() != JValueType::JDict) {
+    target = takeValue(patch);
+    return;
+  }
+  if (target.getType() != JValueType::JDict) {
+    target = JObject(JValueType::JDict);
+  }
+  dict_t &dict = target.getDict();
+  for (auto &[key, value] : patch.getDict()) {
+    if (value.getType() == JValueType::JNull) {
+      auto found = dict.find(key);
+      if (found != dict.end()) {
+        dict.erase(found);
+      }
+    } else {
+      mergePatch(dict[key], value);
+    }
+  }
+}
+} // namespace
+
+JObject diff(const JObject &from, const JObject &to) {
+  JObject patch(JValueType::JList);
+  std::string path;
+  diffValue(from, to, path, patch);
+  return patch;
+}
+
+void apply_patch(JObject &document, const JObject &patch) {
+  applyPatch(document, patch);
+}
+
+void apply_patch(JObject &document, JObject &&patch) {
+  applyPatch(document, patch);
+}
+
+void merge_patch(JObject &document, const JObject &patch) {
+  mergePatch(document, patch);
+}
+
+void merge_patch(JObject &document, JObject &&patch) {
+  mergePatch(document, patch);
+}
+
+JSON_NAMESPACE_END
@@ -0,0 +1,62 @@
+#ifndef JSON_PATCH_HPP
+#define JSON_PATCH_HPP
+
+#include "Json.h"
+
+namespace qjson {
+/**
+ * @brief Computes an RFC 6902 JSON Patch turning one document into
+ * another.
+ *
+ * Dicts are compared key by key, and lists after trimming their common
+ * head and tail, so a change deep in a large document yields operations
+ * for that change only. Subtrees are only compared as far as their first
+ * difference, and a subtree compared with itself is skipped outright.
+ * @param from The original document.
+ * @param to The target document.
+ * @return A list of operations; empty if the documents are equal.
+ */
+JObject diff(const JObject &from, const JObject &to);
+
+/**
+ * @brief Applies an RFC 6902 JSON Patch in place.
+ *
+ * Supports add, remove, replace, move, copy and test. "move" relinks the
+ * subtree instead of copying it. The patch is atomic: if an operation
+ * fails, the ones before it are undone, and the document is restored to
+ * its original state. Undoing moves values back rather than copying them.
+ * @param document The document to patch.
+ * @param patch A list of operations.
+ * @throw std::logic_error If the patch is malformed, a path does not
+ * resolve, or a test fails.
+ */
+void apply_patch(JObject &document, const JObject &patch);
+
+/**
+ * @brief Applies an RFC 6902 JSON Patch in place, moving the values of
+ * its operations into the document instead of copying them.
+ *
+ * The patch is left valid but unspecified.
+ */
+void apply_patch(JObject &document, JObject &&patch);
+
+/**
+ * @brief Applies an RFC 7386 JSON Merge Patch in place.
+ *
+ * Dict members of the patch are merged recursively, null members remove
+ * keys, and any other value replaces the target.
+ * @param document The document to patch.
+ * @param patch The merge patch.
+ */
+void merge_patch(JObject &document, const JObject &patch);
+
+/**
+ * @brief Applies an RFC 7386 JSON Merge Patch in place, moving the
+ * patch's subtrees into the document instead of copying them.
+ *
+ * The patch is left valid but unspecified.
+ */
+void merge_patch(JObject &document, JObject &&patch);
+} // namespace qjson
+
+#endif // !JSON_PATCH_HPP
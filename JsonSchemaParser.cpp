@@ -0,0 +1,346 @@
+#include "JsonSchemaParser.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define JSON_NAMESPACE_START namespace qjson {
+#define JSON_NAMESPACE_END }
+
+JSON_NAMESPACE_START
+
+namespace {
+/// Expected keys per dict; the slots seen are tracked in one 64-bit mask.
+constexpr std::size_t max_slots = 64;
+
+/// Thrown where the input leaves the grammar the specialized path handles.
+struct Mismatch {};
+
+bool hasType(const JObject &schema, std::string_view type) {
+  if (!schema.hasMember("type")) {
+    return false;
+  }
+  const JObject &types = schema["type"];
+  if (types.getType() == JValueType::JString) {
+    return types.getPMRString() == type;
+  }
+  if (types.getType() == JValueType::JList) {
+    for (const auto &item : types.getList()) {
+      if (item.getType() == JValueType::JString &&
+          item.getPMRString() == type) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+} // namespace
+
+/// What is expected of a value: a dict of known keys, or a list of items
+/// of a known shape. A value expecting neither is parsed generically.
+struct JSchemaParser::Value {
+  std::unique_ptr<Object> object;
+  std::unique_ptr<Value> items;
+
+  bool empty() const noexcept { return !object && !items; }
+};
+
+struct JSchemaParser::Object {
+  struct Slot {
+    std::string key;
+    std::string quoted; ///< "key" as it appears unescaped, or empty.
+    Value value;
+  };
+
+  void add(std::string_view key, Value value) {
+    Slot slot{std::string(key), {}, std::move(value)};
+    if (key.find_first_of("\"\\") == std::string_view::npos) {
+      slot.quoted = '\"' + slot.key + '\"';
+    }
+    slots.push_back(std::move(slot));
+  }
+
+  /// Builds the prototype once every slot is added.
+  void seal() {
+    prototype.reserve(slots.size());
+    for (const auto &slot : slots) {
+      prototype.emplace(slot.key, JObject());
+    }
+    for (const auto &entry : prototype) {
+      order.push_back(find(entry.first));
+    }
+  }
+
+  std::size_t find(std::string_view key) const noexcept {
+    for (std::size_t i = 0; i < slots.size(); i++) {
+      if (slots[i].key == key) {
+        return i;
+      }
+    }
+    return slots.size();
+  }
+
+  std::vector<Slot> slots; ///< In the order keys are expected.
+  dict_t prototype;        ///< Every expected key, with null values.
+  std::vector<std::size_t> order; ///< Slot of each prototype entry.
+};
+
+JSchemaParser::JSchemaParser() : m_root(std::make_unique<Value>()) {}
+
+JSchemaParser::JSchemaParser(JSchemaParser &&parser) noexcept = default;
+
+JSchemaParser::~JSchemaParser() = default;
+
+JSchemaParser &
+JSchemaParser::operator=(JSchemaParser &&parser) noexcept = default;
+
+JSchemaParser JSchemaParser::fromSchema(const JObject &schema) {
+  if (schema.getType() != JValueType::JDict) {
+    throw std::logic_error("Invalid Schema");
+  }
+  JSchemaParser parser;
+  *parser.m_root = compileSchema_(schema);
+  return parser;
+}
+
+JSchemaParser JSchemaParser::fromShape(const JShapeProfile &profile,
+                                       double minFrequency) {
+  JSchemaParser parser;
+  *parser.m_root = compileShape_(profile.root(), minFrequency);
+  return parser;
+}
+
+JSchemaParser::Value JSchemaParser::compileSchema_(const JObject &schema) {
+  Value value;
+  if (schema.getType() != JValueType::JDict) {
+    return value;
+  }
+  const bool typed = schema.hasMember("type");
+
+  if ((hasType(schema, "object") || !typed) &&
+      schema.hasMember("properties") &&
+      schema["properties"].getType() == JValueType::JDict) {
+    const dict_t &properties = schema["properties"].getDict();
+    std::vector<std::string_view> keys;
+    if (schema.hasMember("required") &&
+        schema["required"].getType() == JValueType::JList) {
+      for (const auto &key : schema["required"].getList()) {
+        if (key.getType() == JValueType::JString &&
+            properties.contains(key.getPMRString()) &&
+            std::find(keys.begin(), keys.end(), key.getPMRString()) ==
+                keys.end()) {
+          keys.emplace_back(key.getPMRString());
+        }
+      }
+    }
+    const std::size_t required = keys.size();
+    for (const auto &entry : properties) {
+      if (std::find(keys.begin(), keys.end(), entry.first) == keys.end()) {
+        keys.emplace_back(entry.first);
+      }
+    }
+    std::sort(keys.begin() + required, keys.end());
+    keys.resize(std::min(keys.size(), max_slots));
+
+    if (!keys.empty()) {
+      auto object = std::make_unique<Object>();
+      for (const auto key : keys) {
+        object->add(key, compileSchema_(properties.find(key)->second));
+      }
+      object->seal();
+      value.object = std::move(object);
+    }
+  }
+
+  if ((hasType(schema, "array") || !typed) && schema.hasMember("items")) {
+    Value items = compileSchema_(schema["items"]);
+    if (!items.empty()) {
+      value.items = std::make_unique<Value>(std::move(items));
+    }
+  }
+  return value;
+}
+
+JSchemaParser::Value JSchemaParser::compileShape_(const JShapeNode &node,
+                                                  double minFrequency) {
+  Value value;
+  const JValueType type = node.dominantType();
+  if (type == JValueType::JDict && !node.members().empty()) {
+    const double dicts =
+        static_cast<double>(node.typeCount(JValueType::JDict));
+    auto object = std::make_unique<Object>();
+    for (const auto &member : node.members()) {
+      if (object->slots.size() == max_slots) {
+        break;
+      }
+      if (static_cast<double>(member.node.count()) / dicts >= minFrequency) {
+        object->add(member.key, compileShape_(member.node, minFrequency));
+      }
+    }
+    if (!object->slots.empty()) {
+      object->seal();
+      value.object = std::move(object);
+    }
+  } else if (type == JValueType::JList && node.items() != nullptr) {
+    Value items = compileShape_(*node.items(), minFrequency);
+    if (!items.empty()) {
+      value.items = std::make_unique<Value>(std::move(items));
+    }
+  }
+  return value;
+}
+
+JObject JSchemaParser::parse(std::string_view data) {
+  try {
+    std::size_t iter = 0;
+    long long error_line = 0;
+    skipSpace(data, data.size(), iter, error_line);
+    return parseValue_(data, iter, *m_root);
+  } catch (const Mismatch &) {
+  } catch (const std::logic_error &) {
+  }
+  // JParser has the final say on what the input means, or why it is
+  // invalid.
+  return JParser::parse(data);
+}
+
+JObject JSchemaParser::parseValue_(std::string_view data, std::size_t &iter,
+                                   const Value &value) {
+  if (iter < data.size()) {
+    if (value.object && data[iter] == '{') {
+      return parseObject_(data, iter, *value.object);
+    }
+    if (value.items && data[iter] == '[') {
+      return parseList_(data, iter, *value.items);
+    }
+  }
+  return parse_(data, data.size(), iter);
+}
+
+JObject JSchemaParser::parseObject_(std::string_view data, std::size_t &iter,
+                                    const Object &object) {
+  const std::size_t data_size = data.size();
+  long long error_line = 0;
+  ++iter;
+  skipSpace(data, data_size, iter, error_line);
+  if (iter < data_size && data[iter] == '}') {
+    ++iter;
+    return JObject(JValueType::JDict);
+  }
+
+  JObject localJO(JValueType::JDict);
+  dict_t &dict = localJO.getDict();
+  dict = object.prototype;
+  // Values are written through pointers, which stay valid when an
+  // unexpected key makes the dict rehash; the iterators, kept to erase
+  // missing keys without hashing them, do not.
+  std::array<dict_t::iterator, max_slots> entries;
+  std::array<JObject *, max_slots> values;
+  bool rehashed = false;
+  std::size_t position = 0;
+  for (auto entry = dict.begin(); entry != dict.end(); ++entry, ++position) {
+    // Copies keep the prototype's order in the common implementations;
+    // the key check covers those that do not.
+    std::size_t slot = object.order[position];
+    if (std::string_view(object.slots[slot].key) != entry->first) {
+      slot = object.find(entry->first);
+    }
+    entries[slot] = entry;
+    values[slot] = &entry->second;
+  }
+
+  std::uint64_t seen = 0;
+  std::size_t next = 0;
+  while (true) {
+    skipSpace(data, data_size, iter, error_line);
+    if (iter >= data_size || data[iter] != '\"') {
+      throw Mismatch();
+    }
+    std::size_t slot = object.slots.size();
+    string_t key;
+    if (next < object.slots.size() && !object.slots[next].quoted.empty() &&
+        data.compare(iter, object.slots[next].quoted.size(),
+                     object.slots[next].quoted) == 0) {
+      slot = next;
+      iter += object.slots[next].quoted.size();
+    } else {
+      key = getString(data, data_size, iter, error_line);
+      slot = object.find(key);
+    }
+    skipSpace(data, data_size, iter, error_line);
+    if (iter >= data_size || data[iter] != ':') {
+      throw Mismatch();
+    }
+    ++iter;
+    skipSpace(data, data_size, iter, error_line);
+    if (slot < object.slots.size()) {
+      *values[slot] = parseValue_(data, iter, object.slots[slot].value);
+      seen |= std::uint64_t{1} << slot;
+      next = slot + 1;
+    } else {
+      const std::size_t buckets = dict.bucket_count();
+      dict[key] = parse_(data, data_size, iter);
+      rehashed = rehashed || dict.bucket_count() != buckets;
+    }
+    skipSpace(data, data_size, iter, error_line);
+    if (iter < data_size && data[iter] == ',') {
+      ++iter;
+      continue;
+    }
+    if (iter < data_size && data[iter] == '}') {
+      ++iter;
+      break;
+    }
+    throw Mismatch();
+  }
+
+  if (std::popcount(seen) != static_cast<int>(object.slots.size())) {
+    for (std::size_t slot = 0; slot < object.slots.size(); slot++) {
+      if ((seen & (std::uint64_t{1} << slot)) != 0) {
+        continue;
+      }
+      if (rehashed) {
+        dict.erase(dict.find(std::string_view(object.slots[slot].key)));
+      } else {
+        dict.erase(entries[slot]);
+      }
+    }
+  }
+  return localJO;
+}
+
+JObject JSchemaParser::parseList_(std::string_view data, std::size_t &iter,
+                                  const Value &items) {
+  const std::size_t data_size = data.size();
+  long long error_line = 0;
+  ++iter;
+  JObject localJO(JValueType::JList);
+  skipSpace(data, data_size, iter, error_line);
+  if (iter < data_size && data[iter] == ']') {
+    ++iter;
+    return localJO;
+  }
+  while (true) {
+    skipSpace(data, data_size, iter, error_line);
+    localJO.push_back(parseValue_(data, iter, items));
+    skipSpace(data, data_size, iter, error_line);
+    if (iter < data_size && data[iter] == ',') {
+      ++iter;
+      continue;
+    }
+    if (iter < data_size && data[iter] == ']') {
+      ++iter;
+      break;
+    }
+    throw Mismatch();
+  }
+  return localJO;
+}
+
+JSON_NAMESPACE_END
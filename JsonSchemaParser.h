@@ -0,0 +1,87 @@
+#ifndef JSON_SCHEMA_PARSER_HPP
+#define JSON_SCHEMA_PARSER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+#include "Json.h"
+#include "JsonShape.h"
+
+namespace qjson {
+/**
+ * @brief Parser specialized for documents of a known shape.
+ *
+ * The shape, taken from a JSON Schema or from a JShapeProfile of sample
+ * traffic, is compiled into a tree of expected dicts. Each dict keeps a
+ * prototype holding all of its expected keys, which is copied for every
+ * parsed dict of that shape: the keys and their hashes are copied, never
+ * decoded or hashed again. Keys are matched by comparing the input with
+ * the key expected next, so in-order documents cost one memcmp per key,
+ * and each value is written straight into its slot of the copy.
+ *
+ * Anything else falls back to the generic parser: unknown keys are
+ * inserted as JParser would, values of unexpected types are parsed
+ * generically, missing keys are erased afterwards. Input that the
+ * specialized path does not accept is parsed again by JParser, so the
+ * result, or the exception, is always the one JParser::parse() gives.
+ */
+class JSchemaParser : private JParser {
+public:
+  /// A parser with no expectations; it behaves like JParser.
+  JSchemaParser();
+  JSchemaParser(JSchemaParser &&parser) noexcept;
+  ~JSchemaParser();
+
+  JSchemaParser &operator=(JSchemaParser &&parser) noexcept;
+
+  /**
+   * @brief Compiles a JSON Schema.
+   *
+   * Uses "type", "properties", "required" and "items"; other keywords do
+   * not change what is parsed. Properties are expected in "required"
+   * order, then by name; other orders still match, at the cost of a
+   * lookup per out-of-order key.
+   * @param schema The schema, a dict.
+   * @return The specialized parser.
+   */
+  static JSchemaParser fromSchema(const JObject &schema);
+
+  /**
+   * @brief Compiles the shape seen by a profile.
+   *
+   * Dict members are expected in the order the profile first saw them.
+   * @param profile A profile fed with raw samples of the documents.
+   * @param minFrequency Members present in fewer than this share of
+   * their dicts are left to the generic path.
+   * @return The specialized parser.
+   */
+  static JSchemaParser fromShape(const JShapeProfile &profile,
+                                 double minFrequency = 0.5);
+
+  /**
+   * @brief Parses JSON data.
+   * @param data The JSON data to parse.
+   * @return The parsed JSON object, equal to JParser::parse(data).
+   */
+  JObject parse(std::string_view data);
+
+private:
+  struct Value;
+  struct Object;
+
+  static Value compileSchema_(const JObject &schema);
+  static Value compileShape_(const JShapeNode &node, double minFrequency);
+
+  JObject parseValue_(std::string_view data, std::size_t &iter,
+                      const Value &value);
+  JObject parseObject_(std::string_view data, std::size_t &iter,
+                       const Object &object);
+  JObject parseList_(std::string_view data, std::size_t &iter,
+                     const Value &items);
+
+  std::unique_ptr<Value> m_root;
+};
+} // namespace qjson
+
+#endif // !JSON_SCHEMA_PARSER_HPP
@@ -0,0 +1,551 @@
+#include "JsonShape.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#define JSON_NAMESPACE_START namespace qjson {
+#define JSON_NAMESPACE_END }
+
+JSON_NAMESPACE_START
+
+namespace {
+constexpr const char *type_names[] = {"null", "int",  "double", "bool",
+                                      "string", "list", "dict"};
+
+JObject toJObject(std::size_t value) {
+  return JObject(static_cast<int_t>(value));
+}
+
+[[noreturn]] void fail(std::string_view data, std::size_t iter) {
+  // Lines are counted only here, so the scan itself does not track them.
+  const auto line = std::count(data.begin(),
+                               data.begin() + std::min(iter, data.size()),
+                               '\n');
+  throw std::logic_error("Invalid Input, in line " + std::to_string(line));
+}
+
+// The whitespace JParser::skipSpace accepts.
+void skipSpace(std::string_view data, std::size_t &iter) {
+  while (iter < data.size() &&
+         (data[iter] == ' ' || data[iter] == '\t' || data[iter] == '\n')) {
+    ++iter;
+  }
+}
+
+/**
+ * @brief Reads the string starting at data[iter] and returns its length
+ * after unescaping.
+ * @param key If not null, receives the unescaped text: a view of data if
+ * the string has no escapes, of scratch otherwise.
+ */
+std::size_t scanString(std::string_view data, std::size_t &iter,
+                       std::string_view *key, std::string &scratch) {
+  const std::size_t start = ++iter;
+  std::size_t escapes = 0;
+  bool decoded = false;
+  while (true) {
+    const std::size_t stop = data.find_first_of("\"\\", iter);
+    if (stop == std::string_view::npos) {
+      fail(data, data.size());
+    }
+    if (key != nullptr && decoded) {
+      scratch.append(data.substr(iter, stop - iter));
+    }
+    iter = stop;
+    if (data[iter] == '\"') {
+      break;
+    }
+    if (key != nullptr && !decoded) {
+      decoded = true;
+      scratch.assign(data.substr(start, iter - start));
+    }
+    if (++iter >= data.size()) {
+      fail(data, iter);
+    }
+    char unescaped = 0;
+    switch (data[iter]) {
+    case 'n':
+      unescaped = '\n';
+      break;
+    case 'b':
+      unescaped = '\b';
+      break;
+    case 'f':
+      unescaped = '\f';
+      break;
+    case 'r':
+      unescaped = '\r';
+      break;
+    case 't':
+      unescaped = '\t';
+      break;
+    case '\\':
+    case '\"':
+    case '/':
+      unescaped = data[iter];
+      break;
+    default:
+      fail(data, iter);
+    }
+    if (decoded) {
+      scratch += unescaped;
+    }
+    ++escapes;
+    ++iter;
+  }
+  const std::size_t length = iter - start - escapes;
+  if (key != nullptr) {
+    *key = decoded ? std::string_view(scratch) : data.substr(start, length);
+  }
+  ++iter;
+  return length;
+}
+
+std::size_t scanDigits(std::string_view data, std::size_t &iter) {
+  const std::size_t start = iter;
+  while (iter < data.size() && data[iter] >= '0' && data[iter] <= '9') {
+    ++iter;
+  }
+  return iter - start;
+}
+
+void scanLiteral(std::string_view data, std::size_t &iter,
+                 std::string_view literal) {
+  if (data.substr(iter, literal.size()) != literal) {
+    fail(data, iter);
+  }
+  iter += literal.size();
+}
+} // namespace
+
+void JLengthHistogram::record(std::size_t length) noexcept {
+  ++m_buckets[std::bit_width(length)];
+  ++m_count;
+  m_sum += length;
+  m_min = std::min(m_min, length);
+  m_max = std::max(m_max, length);
+}
+
+void JLengthHistogram::merge(const JLengthHistogram &other) noexcept {
+  for (std::size_t i = 0; i < bucketCount; i++) {
+    m_buckets[i] += other.m_buckets[i];
+  }
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  m_min = std::min(m_min, other.m_min);
+  m_max = std::max(m_max, other.m_max);
+}
+
+JObject JLengthHistogram::to_jobject() const {
+  JObject result(JValueType::JDict);
+  result["count"] = toJObject(m_count);
+  result["min"] = toJObject(min());
+  result["max"] = toJObject(m_max);
+  result["mean"] = mean();
+  JObject buckets(JValueType::JDict);
+  for (std::size_t i = 0; i < bucketCount; i++) {
+    if (m_buckets[i] == 0) {
+      continue;
+    }
+    const std::size_t low = i == 0 ? 0 : std::size_t{1} << (i - 1);
+    std::string range = std::to_string(low);
+    if (i > 1) {
+      range += '-' + std::to_string(low * 2 - 1);
+    }
+    buckets[range] = toJObject(m_buckets[i]);
+  }
+  result["buckets"] = std::move(buckets);
+  return result;
+}
+
+JShapeNode::JShapeNode(const JShapeNode &node)
+    : m_count(node.m_count), m_types(node.m_types), m_intMin(node.m_intMin),
+      m_intMax(node.m_intMax), m_stringLengths(node.m_stringLengths),
+      m_listLengths(node.m_listLengths), m_dictSizes(node.m_dictSizes),
+      m_members(node.m_members), m_index(node.m_index),
+      m_otherKeys(node.m_otherKeys),
+      m_other(node.m_other ? std::make_unique<JShapeNode>(*node.m_other)
+                           : nullptr),
+      m_items(node.m_items ? std::make_unique<JShapeNode>(*node.m_items)
+                           : nullptr) {}
+
+JShapeNode::JShapeNode(JShapeNode &&node) noexcept = default;
+
+JShapeNode::~JShapeNode() = default;
+
+JShapeNode &JShapeNode::operator=(const JShapeNode &node) {
+  if (this != &node) {
+    *this = JShapeNode(node);
+  }
+  return *this;
+}
+
+JShapeNode &JShapeNode::operator=(JShapeNode &&node) noexcept = default;
+
+JValueType JShapeNode::dominantType() const noexcept {
+  return static_cast<JValueType>(
+      std::max_element(m_types.begin(), m_types.end()) - m_types.begin());
+}
+
+const JShapeNode *JShapeNode::member(std::string_view key) const {
+  auto found = m_index.find(key);
+  return found == m_index.end() ? nullptr : &m_members[found->second].node;
+}
+
+void JShapeNode::recordInt_(int_t value) noexcept {
+  if (m_types[JValueType::JInt] == 1) {
+    m_intMin = value;
+    m_intMax = value;
+    return;
+  }
+  m_intMin = std::min(m_intMin, value);
+  m_intMax = std::max(m_intMax, value);
+}
+
+JShapeNode &JShapeNode::member_(std::string_view key, std::size_t &hint,
+                                std::size_t maxKeys) {
+  // Documents from one producer list their keys in the same order, so the
+  // member after the previous one is checked before hashing the key.
+  if (hint < m_members.size() && m_members[hint].key == key) {
+    return m_members[hint++].node;
+  }
+  auto found = m_index.find(key);
+  if (found != m_index.end()) {
+    hint = found->second + 1;
+    return m_members[found->second].node;
+  }
+  if (m_members.size() >= maxKeys) {
+    ++m_otherKeys;
+    if (!m_other) {
+      m_other = std::make_unique<JShapeNode>();
+    }
+    return *m_other;
+  }
+  m_index.emplace(std::string(key), m_members.size());
+  m_members.push_back({std::string(key), JShapeNode()});
+  hint = m_members.size();
+  return m_members.back().node;
+}
+
+JShapeNode &JShapeNode::items_() {
+  if (!m_items) {
+    m_items = std::make_unique<JShapeNode>();
+  }
+  return *m_items;
+}
+
+void JShapeNode::merge_(const JShapeNode &other, std::size_t maxKeys) {
+  if (other.m_types[JValueType::JInt] != 0) {
+    if (m_types[JValueType::JInt] == 0) {
+      m_intMin = other.m_intMin;
+      m_intMax = other.m_intMax;
+    } else {
+      m_intMin = std::min(m_intMin, other.m_intMin);
+      m_intMax = std::max(m_intMax, other.m_intMax);
+    }
+  }
+  m_count += other.m_count;
+  for (std::size_t i = 0; i < m_types.size(); i++) {
+    m_types[i] += other.m_types[i];
+  }
+  m_stringLengths.merge(other.m_stringLengths);
+  m_listLengths.merge(other.m_listLengths);
+  m_dictSizes.merge(other.m_dictSizes);
+
+  std::size_t hint = 0;
+  for (const auto &member : other.m_members) {
+    const std::size_t others = m_otherKeys;
+    JShapeNode &node = member_(member.key, hint, maxKeys);
+    // member_ counted one overflowing key; the member stands for count.
+    if (m_otherKeys != others) {
+      m_otherKeys += member.node.m_count - 1;
+    }
+    node.merge_(member.node, maxKeys);
+  }
+  if (other.m_other) {
+    m_otherKeys += other.m_otherKeys;
+    if (!m_other) {
+      m_other = std::make_unique<JShapeNode>();
+    }
+    m_other->merge_(*other.m_other, maxKeys);
+  }
+  if (other.m_items) {
+    items_().merge_(*other.m_items, maxKeys);
+  }
+}
+
+JObject JShapeNode::to_jobject() const {
+  JObject result(JValueType::JDict);
+  result["count"] = toJObject(m_count);
+  JObject types(JValueType::JDict);
+  for (std::size_t i = 0; i < m_types.size(); i++) {
+    if (m_types[i] != 0) {
+      types[type_names[i]] = toJObject(m_types[i]);
+    }
+  }
+  result["types"] = std::move(types);
+
+  if (m_types[JValueType::JInt] != 0) {
+    result["int_min"] = m_intMin;
+    result["int_max"] = m_intMax;
+  }
+  if (m_types[JValueType::JString] != 0) {
+    result["string_lengths"] = m_stringLengths.to_jobject();
+  }
+  if (m_types[JValueType::JList] != 0) {
+    result["list_lengths"] = m_listLengths.to_jobject();
+    if (m_items) {
+      result["items"] = m_items->to_jobject();
+    }
+  }
+  if (m_types[JValueType::JDict] != 0) {
+    result["dict_sizes"] = m_dictSizes.to_jobject();
+    const double dicts = static_cast<double>(m_types[JValueType::JDict]);
+    JObject keys(JValueType::JList);
+    keys.getList().reserve(m_members.size());
+    for (const auto &member : m_members) {
+      JObject entry = member.node.to_jobject();
+      entry["key"] = std::string_view(member.key);
+      entry["frequency"] = static_cast<double>(member.node.m_count) / dicts;
+      keys.push_back(std::move(entry));
+    }
+    result["keys"] = std::move(keys);
+    if (m_other) {
+      result["other_keys"] = toJObject(m_otherKeys);
+      result["other"] = m_other->to_jobject();
+    }
+  }
+  return result;
+}
+
+JShapeProfile::JShapeProfile(std::size_t sampleEvery, std::size_t maxKeys)
+    : m_sampleEvery(std::max<std::size_t>(sampleEvery, 1)),
+      m_maxKeys(maxKeys) {}
+
+bool JShapeProfile::add(const JObject &jobject) {
+  if (!sample_()) {
+    return false;
+  }
+  add_(jobject, m_root);
+  return true;
+}
+
+bool JShapeProfile::addRaw(std::string_view data) {
+  if (!sample_()) {
+    return false;
+  }
+  std::size_t iter = 0;
+  scan_(data, iter, m_root);
+  return true;
+}
+
+void JShapeProfile::merge(const JShapeProfile &other) {
+  m_documents += other.m_documents;
+  m_sampled += other.m_sampled;
+  m_root.merge_(other.m_root, m_maxKeys);
+}
+
+void JShapeProfile::reset() {
+  m_documents = 0;
+  m_sampled = 0;
+  m_root = JShapeNode();
+}
+
+JObject JShapeProfile::to_jobject() const {
+  JObject result(JValueType::JDict);
+  result["documents"] = toJObject(m_documents);
+  result["sampled"] = toJObject(m_sampled);
+  result["shape"] = m_root.to_jobject();
+  return result;
+}
+
+bool JShapeProfile::sample_() noexcept {
+  if (m_documents++ % m_sampleEvery != 0) {
+    return false;
+  }
+  ++m_sampled;
+  return true;
+}
+
+void JShapeProfile::add_(const JObject &jobject, JShapeNode &node) {
+  const JValueType type = jobject.getType();
+  node.recordType_(type);
+  switch (type) {
+  case JValueType::JInt:
+    node.recordInt_(jobject.getInt());
+    break;
+  case JValueType::JString:
+    node.m_stringLengths.record(jobject.getPMRString().size());
+    break;
+  case JValueType::JList: {
+    const list_t &list = jobject.getList();
+    node.m_listLengths.record(list.size());
+    if (list.empty()) {
+      break;
+    }
+    JShapeNode &items = node.items_();
+    for (const auto &item : list) {
+      add_(item, items);
+    }
+    break;
+  }
+  case JValueType::JDict: {
+    const dict_t &dict = jobject.getDict();
+    node.m_dictSizes.record(dict.size());
+    std::size_t hint = 0;
+    for (const auto &[key, value] : dict) {
+      add_(value, node.member_(key, hint, m_maxKeys));
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void JShapeProfile::scan_(std::string_view data, std::size_t &iter,
+                          JShapeNode &node) {
+  skipSpace(data, iter);
+  if (iter >= data.size()) {
+    fail(data, iter);
+  }
+  switch (data[iter]) {
+  case '{': {
+    node.recordType_(JValueType::JDict);
+    ++iter;
+    skipSpace(data, iter);
+    std::size_t keys = 0;
+    if (iter < data.size() && data[iter] == '}') {
+      ++iter;
+      node.m_dictSizes.record(keys);
+      return;
+    }
+    std::size_t hint = 0;
+    std::string scratch;
+    while (true) {
+      skipSpace(data, iter);
+      if (iter >= data.size() || data[iter] != '\"') {
+        fail(data, iter);
+      }
+      std::string_view key;
+      scanString(data, iter, &key, scratch);
+      skipSpace(data, iter);
+      if (iter >= data.size() || data[iter] != ':') {
+        fail(data, iter);
+      }
+      ++iter;
+      scan_(data, iter, node.member_(key, hint, m_maxKeys));
+      ++keys;
+      skipSpace(data, iter);
+      if (iter < data.size() && data[iter] == ',') {
+        ++iter;
+        continue;
+      }
+      if (iter < data.size() && data[iter] == '}') {
+        ++iter;
+        break;
+      }
+      fail(data, iter);
+    }
+    node.m_dictSizes.record(keys);
+    return;
+  }
+  case '[': {
+    node.recordType_(JValueType::JList);
+    ++iter;
+    skipSpace(data, iter);
+    std::size_t items = 0;
+    if (iter < data.size() && data[iter] == ']') {
+      ++iter;
+      node.m_listLengths.record(items);
+      return;
+    }
+    JShapeNode &itemNode = node.items_();
+    while (true) {
+      scan_(data, iter, itemNode);
+      ++items;
+      skipSpace(data, iter);
+      if (iter < data.size() && data[iter] == ',') {
+        ++iter;
+        continue;
+      }
+      if (iter < data.size() && data[iter] == ']') {
+        ++iter;
+        break;
+      }
+      fail(data, iter);
+    }
+    node.m_listLengths.record(items);
+    return;
+  }
+  case '\"': {
+    std::string scratch;
+    node.m_stringLengths.record(scanString(data, iter, nullptr, scratch));
+    node.recordType_(JValueType::JString);
+    return;
+  }
+  case 't':
+    scanLiteral(data, iter, "true");
+    node.recordType_(JValueType::JBool);
+    return;
+  case 'f':
+    scanLiteral(data, iter, "false");
+    node.recordType_(JValueType::JBool);
+    return;
+  case 'n':
+    scanLiteral(data, iter, "null");
+    node.recordType_(JValueType::JNull);
+    return;
+  default:
+    break;
+  }
+
+  // A number, classified the way JParser::getNumber does: a fraction or
+  // an exponent makes it a JDouble.
+  const std::size_t start = iter;
+  if (data[iter] == '-') {
+    ++iter;
+  }
+  if (scanDigits(data, iter) == 0) {
+    fail(data, iter);
+  }
+  bool isDouble = false;
+  if (iter < data.size() && data[iter] == '.') {
+    ++iter;
+    isDouble = true;
+    if (scanDigits(data, iter) == 0) {
+      fail(data, iter);
+    }
+  }
+  if (iter < data.size() && (data[iter] == 'e' || data[iter] == 'E')) {
+    ++iter;
+    isDouble = true;
+    if (iter < data.size() && (data[iter] == '+' || data[iter] == '-')) {
+      ++iter;
+    }
+    if (scanDigits(data, iter) == 0) {
+      fail(data, iter);
+    }
+  }
+  if (isDouble) {
+    node.recordType_(JValueType::JDouble);
+    return;
+  }
+  int_t value = 0;
+  const auto result =
+      std::from_chars(data.data() + start, data.data() + iter, value);
+  if (result.ec != std::errc()) {
+    value = data[start] == '-' ? std::numeric_limits<int_t>::min()
+                               : std::numeric_limits<int_t>::max();
+  }
+  node.recordType_(JValueType::JInt);
+  node.recordInt_(value);
+}
+
+JSON_NAMESPACE_END
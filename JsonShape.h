@@ -0,0 +1,231 @@
+#ifndef JSON_SHAPE_HPP
+#define JSON_SHAPE_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Json.h"
+
+namespace qjson {
+/**
+ * @brief Histogram of lengths in power-of-two buckets.
+ *
+ * Bucket 0 counts length 0 and bucket i counts lengths in
+ * [2^(i-1), 2^i), so recording is one bit_width and an increment.
+ */
+class JLengthHistogram {
+public:
+  static constexpr std::size_t bucketCount = 65;
+
+  void record(std::size_t length) noexcept;
+  void merge(const JLengthHistogram &other) noexcept;
+
+  std::size_t count() const noexcept { return m_count; }
+  std::size_t min() const noexcept { return m_count == 0 ? 0 : m_min; }
+  std::size_t max() const noexcept { return m_max; }
+  double mean() const noexcept {
+    return m_count == 0 ? 0 : static_cast<double>(m_sum) / m_count;
+  }
+  const std::array<std::size_t, bucketCount> &buckets() const noexcept {
+    return m_buckets;
+  }
+
+  /**
+   * @brief Exports the histogram as a dict of count, min, max, mean and
+   * "buckets": the non-empty buckets keyed by range ("0", "1", "2-3", ...).
+   */
+  JObject to_jobject() const;
+
+private:
+  std::array<std::size_t, bucketCount> m_buckets{};
+  std::size_t m_count = 0;
+  std::size_t m_sum = 0;
+  std::size_t m_min = static_cast<std::size_t>(-1);
+  std::size_t m_max = 0;
+};
+
+struct JShapeMember;
+
+/**
+ * @brief Everything seen at one path of the profiled documents.
+ *
+ * A node records the types of the values found at its path and, per type,
+ * what they looked like: the range of integers, the lengths of strings and
+ * lists, the keys of dicts. Dict members and list items are nodes of their
+ * own, so the profile is a tree that mirrors the documents.
+ */
+class JShapeNode {
+public:
+  JShapeNode() = default;
+  JShapeNode(const JShapeNode &node);
+  JShapeNode(JShapeNode &&node) noexcept;
+  ~JShapeNode();
+
+  JShapeNode &operator=(const JShapeNode &node);
+  JShapeNode &operator=(JShapeNode &&node) noexcept;
+
+  /// Number of values seen at this path.
+  std::size_t count() const noexcept { return m_count; }
+  /// Number of those values that had a given type.
+  std::size_t typeCount(JValueType type) const noexcept {
+    return m_types[type];
+  }
+  /// The most frequent type; JNull if nothing was seen.
+  JValueType dominantType() const noexcept;
+
+  /// Smallest and largest JInt seen; meaningful if typeCount(JInt) != 0.
+  int_t intMin() const noexcept { return m_intMin; }
+  int_t intMax() const noexcept { return m_intMax; }
+
+  /// String lengths in bytes, after unescaping.
+  const JLengthHistogram &stringLengths() const noexcept {
+    return m_stringLengths;
+  }
+  const JLengthHistogram &listLengths() const noexcept {
+    return m_listLengths;
+  }
+  /// Number of keys per dict.
+  const JLengthHistogram &dictSizes() const noexcept { return m_dictSizes; }
+
+  /**
+   * @brief Dict members, in the order they were first seen.
+   *
+   * Raw JSON is profiled in document order, so for stable producers this
+   * is the order their keys are written in. Parsed JObjects only give
+   * their hash table order.
+   */
+  const std::vector<JShapeMember> &members() const noexcept {
+    return m_members;
+  }
+  /// The node of a dict member, or nullptr if the key was never seen.
+  const JShapeNode *member(std::string_view key) const;
+  /// Occurrences of keys beyond the profile's key limit; their values
+  /// are profiled together in otherMembers().
+  std::size_t otherKeys() const noexcept { return m_otherKeys; }
+  const JShapeNode *otherMembers() const noexcept { return m_other.get(); }
+
+  /// All list items at this path, merged; nullptr if no list had any.
+  const JShapeNode *items() const noexcept { return m_items.get(); }
+
+  /**
+   * @brief Exports the node, and everything below it, as JSON.
+   */
+  JObject to_jobject() const;
+
+private:
+  friend class JShapeProfile;
+
+  void recordType_(JValueType type) noexcept {
+    ++m_count;
+    ++m_types[type];
+  }
+  void recordInt_(int_t value) noexcept;
+  JShapeNode &member_(std::string_view key, std::size_t &hint,
+                      std::size_t maxKeys);
+  JShapeNode &items_();
+  void merge_(const JShapeNode &other, std::size_t maxKeys);
+
+  std::size_t m_count = 0;
+  std::array<std::size_t, 7> m_types{};
+  int_t m_intMin = 0;
+  int_t m_intMax = 0;
+  JLengthHistogram m_stringLengths;
+  JLengthHistogram m_listLengths;
+  JLengthHistogram m_dictSizes;
+  std::vector<JShapeMember> m_members;
+  std::unordered_map<std::string, std::size_t, string_hash, std::equal_to<>>
+      m_index;
+  std::size_t m_otherKeys = 0;
+  std::unique_ptr<JShapeNode> m_other;
+  std::unique_ptr<JShapeNode> m_items;
+};
+
+/**
+ * @brief A dict key and the values found under it.
+ */
+struct JShapeMember {
+  std::string key;
+  JShapeNode node;
+};
+
+/**
+ * @brief Aggregated shape of a stream of JSON documents.
+ *
+ * Documents are added either parsed or as raw text; raw text is walked
+ * without building a JObject, which is several times cheaper than parsing
+ * it. With sampleEvery > 1 only every n-th document is profiled, so a
+ * profile can sit on a live path; the others cost a counter increment.
+ *
+ * A profile is not synchronized. Give each thread its own and merge()
+ * them.
+ */
+class JShapeProfile {
+public:
+  /**
+   * @param sampleEvery Profile one document out of this many.
+   * @param maxKeys Distinct keys kept per dict path; further keys (ids
+   * used as keys, say) are counted in JShapeNode::otherKeys().
+   */
+  explicit JShapeProfile(std::size_t sampleEvery = 1,
+                         std::size_t maxKeys = 256);
+
+  /**
+   * @brief Offers a parsed document.
+   * @return true if it was sampled.
+   */
+  bool add(const JObject &jobject);
+
+  /**
+   * @brief Offers a raw JSON document.
+   *
+   * The text is checked with the grammar JParser accepts; a malformed
+   * document throws std::logic_error, and whatever was read of it before
+   * the error stays counted.
+   * @return true if it was sampled.
+   */
+  bool addRaw(std::string_view data);
+
+  /**
+   * @brief Adds the documents of another profile to this one.
+   */
+  void merge(const JShapeProfile &other);
+
+  void reset();
+
+  /// Documents offered, sampled or not.
+  std::size_t documents() const noexcept { return m_documents; }
+  /// Documents profiled.
+  std::size_t sampled() const noexcept { return m_sampled; }
+  const JShapeNode &root() const noexcept { return m_root; }
+
+  /**
+   * @brief Exports the profile as JSON.
+   *
+   * The result is a dict with "documents", "sampled" and "shape", the
+   * root node. A node holds its "count" and "types", then per type
+   * "int_min"/"int_max", "string_lengths", "list_lengths" with "items",
+   * and "dict_sizes" with "keys": a list, in first-seen order, of member
+   * nodes carrying their "key" and "frequency" (the share of dicts at
+   * that path that had the key).
+   */
+  JObject to_jobject() const;
+
+private:
+  bool sample_() noexcept;
+  void add_(const JObject &jobject, JShapeNode &node);
+  void scan_(std::string_view data, std::size_t &iter, JShapeNode &node);
+
+  std::size_t m_sampleEvery;
+  std::size_t m_maxKeys;
+  std::size_t m_documents = 0;
+  std::size_t m_sampled = 0;
+  JShapeNode m_root;
+};
+} // namespace qjson
+
+#endif // !JSON_SHAPE_HPP
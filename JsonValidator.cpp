@@ -0,0 +1,948 @@
+#include "JsonValidator.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#define JSON_NAMESPACE_START namespace qjson {
+#define JSON_NAMESPACE_END }
+
+JSON_NAMESPACE_START
+
+namespace {
+constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+/// Deepest chain of subschemas applied to the same value; stops schemas
+/// such as {"$ref": "#"} that recurse without consuming the document.
+/// Descending into a member or item starts a new chain.
+constexpr std::size_t max_schema_depth = 512;
+
+/// The "type" keyword's names, as bits.
+enum TypeBits : std::uint8_t {
+  null_bit = 1,
+  boolean_bit = 2,
+  object_bit = 4,
+  array_bit = 8,
+  number_bit = 16,
+  string_bit = 32,
+  integer_bit = 64,
+};
+
+constexpr std::pair<std::string_view, std::uint8_t> type_names[] = {
+    {"null", null_bit},     {"boolean", boolean_bit},
+    {"object", object_bit}, {"array", array_bit},
+    {"number", number_bit}, {"string", string_bit},
+    {"integer", integer_bit}};
+
+bool isNumber(const JObject &jobject) noexcept {
+  return jobject.getType() == JValueType::JInt ||
+         jobject.getType() == JValueType::JDouble;
+}
+
+double_t toNumber(const JObject &jobject) {
+  return jobject.getType() == JValueType::JInt
+             ? static_cast<double_t>(jobject.getInt())
+             : jobject.getDouble();
+}
+
+std::uint8_t typeBits(const JObject &jobject) {
+  switch (jobject.getType()) {
+  case JValueType::JNull:
+    return null_bit;
+  case JValueType::JBool:
+    return boolean_bit;
+  case JValueType::JDict:
+    return object_bit;
+  case JValueType::JList:
+    return array_bit;
+  case JValueType::JString:
+    return string_bit;
+  case JValueType::JInt:
+    return number_bit | integer_bit;
+  case JValueType::JDouble: {
+    const double_t value = jobject.getDouble();
+    return std::isfinite(value) && std::trunc(value) == value
+               ? number_bit | integer_bit
+               : number_bit;
+  }
+  }
+  return 0;
+}
+
+/// JSON equality: as JObject's, except that numbers compare by value.
+bool jsonEqual(const JObject &a, const JObject &b) {
+  if (isNumber(a) && isNumber(b)) {
+    if (a.getType() == JValueType::JInt && b.getType() == JValueType::JInt) {
+      return a.getInt() == b.getInt();
+    }
+    return toNumber(a) == toNumber(b);
+  }
+  if (a.getType() != b.getType()) {
+    return false;
+  }
+  switch (a.getType()) {
+  case JValueType::JList: {
+    const list_t &la = a.getList();
+    const list_t &lb = b.getList();
+    if (la.size() != lb.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < la.size(); i++) {
+      if (!jsonEqual(la[i], lb[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  case JValueType::JDict: {
+    const dict_t &da = a.getDict();
+    const dict_t &db = b.getDict();
+    if (da.size() != db.size()) {
+      return false;
+    }
+    for (const auto &[key, value] : da) {
+      auto found = db.find(key);
+      if (found == db.end() || !jsonEqual(value, found->second)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  default:
+    return a == b;
+  }
+}
+
+/// A hash consistent with jsonEqual(); dict members are combined without
+/// regard to order.
+std::size_t jsonHash(const JObject &jobject) {
+  switch (jobject.getType()) {
+  case JValueType::JNull:
+    return 0x9e3779b97f4a7c15u;
+  case JValueType::JBool:
+    return jobject.getBool() ? 1 : 2;
+  case JValueType::JInt:
+  case JValueType::JDouble:
+    return std::hash<double_t>{}(toNumber(jobject));
+  case JValueType::JString:
+    return string_hash{}(jobject.getPMRString());
+  case JValueType::JList: {
+    std::size_t hash = 3;
+    for (const auto &item : jobject.getList()) {
+      hash = hash * 31 + jsonHash(item);
+    }
+    return hash;
+  }
+  case JValueType::JDict: {
+    std::size_t hash = 5;
+    for (const auto &[key, value] : jobject.getDict()) {
+      hash += string_hash{}(key) ^ (jsonHash(value) * 0x100000001b3u);
+    }
+    return hash;
+  }
+  }
+  return 0;
+}
+
+/// Length in code points of UTF-8 text.
+std::size_t codePoints(std::string_view str) noexcept {
+  return static_cast<std::size_t>(
+      std::count_if(str.begin(), str.end(), [](char c) {
+        return (static_cast<unsigned char>(c) & 0xc0) != 0x80;
+      }));
+}
+
+void appendPointerToken(std::string &path, std::string_view token) {
+  path += '/';
+  for (char c : token) {
+    if (c == '~') {
+      path += "~0";
+    } else if (c == '/') {
+      path += "~1";
+    } else {
+      path += c;
+    }
+  }
+}
+
+std::string formatNumber(double_t value) {
+  if (std::trunc(value) == value && std::fabs(value) < 1e18L) {
+    return std::to_string(static_cast<int_t>(value));
+  }
+  return JObject(value).to_string();
+}
+} // namespace
+
+struct JValidator::Op {
+  enum Code : std::uint8_t {
+    Fail,
+    Ref,
+    Type,
+    Const,
+    Enum,
+    Minimum,
+    Maximum,
+    ExclusiveMinimum,
+    ExclusiveMaximum,
+    MultipleOf,
+    MinLength,
+    MaxLength,
+    Pattern,
+    Items,
+    PrefixItems,
+    Contains,
+    MinItems,
+    MaxItems,
+    UniqueItems,
+    Object,
+    AllOf,
+    AnyOf,
+    OneOf,
+    Not,
+  };
+
+  Code code;
+  std::uint8_t types = 0;  ///< Type: accepted TypeBits.
+  double_t number = 0;     ///< Numeric bound; Contains: maxContains.
+  std::size_t size = 0;    ///< Length bound; Items: prefix length;
+                           ///< Contains: minContains.
+  std::size_t index = 0;   ///< Program, pattern, set, object or list.
+};
+
+struct JValidator::Program {
+  std::vector<Op> ops;
+};
+
+struct JValidator::Pattern {
+  std::string source;
+  std::regex regex;
+};
+
+struct JValidator::ValueSet {
+  bool contains(const JObject &jobject) const {
+    auto [first, last] = values.equal_range(jsonHash(jobject));
+    for (; first != last; ++first) {
+      if (jsonEqual(first->second, jobject)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::unordered_multimap<std::size_t, JObject> values;
+};
+
+struct JValidator::ObjectRules {
+  /// Property name to slot; required names take the first slots.
+  std::unordered_map<std::string, std::size_t, string_hash, std::equal_to<>>
+      slots;
+  std::vector<std::string> names;   ///< Slot to name.
+  std::vector<std::size_t> schemas; ///< Slot to program, or none.
+  std::size_t required = 0;
+  /// patternProperties: pattern and program.
+  std::vector<std::pair<std::size_t, std::size_t>> patterns;
+  /// Program for members matched by neither, or none.
+  std::size_t additional = none;
+  bool additionalForbidden = false;
+  std::size_t minProperties = 0;
+  std::size_t maxProperties = none;
+
+  std::size_t slot(std::string_view name) {
+    auto found = slots.find(name);
+    if (found != slots.end()) {
+      return found->second;
+    }
+    slots.emplace(std::string(name), names.size());
+    names.emplace_back(name);
+    schemas.push_back(none);
+    return names.size() - 1;
+  }
+};
+
+/**
+ * @brief Turns a schema into programs, one per subschema.
+ */
+class JValidator::Compiler {
+public:
+  Compiler(JValidator &validator, const JObject &root)
+      : m_validator(validator), m_root(root) {}
+
+  std::size_t compile(const JObject &schema) {
+    auto found = m_compiled.find(&schema);
+    if (found != m_compiled.end()) {
+      return found->second;
+    }
+    // The index is taken before the body is compiled, so a $ref back to
+    // this schema resolves to it.
+    const std::size_t index = m_validator.m_programs.size();
+    m_validator.m_programs.emplace_back();
+    m_compiled.emplace(&schema, index);
+    Program program = compileBody_(schema);
+    m_validator.m_programs[index] = std::move(program);
+    return index;
+  }
+
+private:
+  Program compileBody_(const JObject &schema) {
+    Program program;
+    if (schema.getType() == JValueType::JBool) {
+      if (!schema.getBool()) {
+        program.ops.push_back({Op::Fail});
+      }
+      return program;
+    }
+    if (schema.getType() != JValueType::JDict) {
+      throw std::logic_error("Invalid Schema: a schema must be a dict or a "
+                             "bool");
+    }
+    const dict_t &dict = schema.getDict();
+    auto &ops = program.ops;
+
+    if (const JObject *ref = keyword_(dict, "$ref")) {
+      if (ref->getType() != JValueType::JString) {
+        throw std::logic_error("Invalid Schema: $ref must be a string");
+      }
+      ops.push_back({Op::Ref, 0, 0, 0, compile(resolve_(ref->getPMRString()))});
+    }
+    if (const JObject *type = keyword_(dict, "type")) {
+      ops.push_back({Op::Type, types_(*type)});
+    }
+    if (const JObject *value = keyword_(dict, "const")) {
+      ops.push_back({Op::Const, 0, 0, 0, valueSet_(&*value, 1)});
+    }
+    if (const JObject *values = keyword_(dict, "enum")) {
+      if (values->getType() != JValueType::JList) {
+        throw std::logic_error("Invalid Schema: enum must be a list");
+      }
+      const list_t &list = values->getList();
+      ops.push_back(
+          {Op::Enum, 0, 0, 0, valueSet_(list.data(), list.size())});
+    }
+
+    number_(dict, "minimum", Op::Minimum, ops);
+    number_(dict, "maximum", Op::Maximum, ops);
+    number_(dict, "exclusiveMinimum", Op::ExclusiveMinimum, ops);
+    number_(dict, "exclusiveMaximum", Op::ExclusiveMaximum, ops);
+    if (number_(dict, "multipleOf", Op::MultipleOf, ops) &&
+        ops.back().number <= 0) {
+      throw std::logic_error("Invalid Schema: multipleOf must be positive");
+    }
+
+    size_(dict, "minLength", Op::MinLength, ops);
+    size_(dict, "maxLength", Op::MaxLength, ops);
+    if (const JObject *pattern = keyword_(dict, "pattern")) {
+      ops.push_back({Op::Pattern, 0, 0, 0, pattern_(*pattern)});
+    }
+
+    std::size_t prefix = 0;
+    if (const JObject *items = keyword_(dict, "prefixItems")) {
+      const std::size_t list = list_(*items, "prefixItems");
+      prefix = m_validator.m_lists[list].size();
+      ops.push_back({Op::PrefixItems, 0, 0, 0, list});
+    }
+    if (const JObject *items = keyword_(dict, "items")) {
+      ops.push_back({Op::Items, 0, 0, prefix, compile(*items)});
+    }
+    if (const JObject *contains = keyword_(dict, "contains")) {
+      Op op{Op::Contains, 0, std::numeric_limits<double_t>::infinity(), 1,
+            compile(*contains)};
+      if (const JObject *min = keyword_(dict, "minContains")) {
+        op.size = toSize_(*min, "minContains");
+      }
+      if (const JObject *max = keyword_(dict, "maxContains")) {
+        op.number = static_cast<double_t>(toSize_(*max, "maxContains"));
+      }
+      ops.push_back(op);
+    }
+    size_(dict, "minItems", Op::MinItems, ops);
+    size_(dict, "maxItems", Op::MaxItems, ops);
+    if (const JObject *unique = keyword_(dict, "uniqueItems")) {
+      if (unique->getType() != JValueType::JBool) {
+        throw std::logic_error("Invalid Schema: uniqueItems must be a bool");
+      }
+      if (unique->getBool()) {
+        ops.push_back({Op::UniqueItems});
+      }
+    }
+
+    objectRules_(dict, ops);
+
+    if (const JObject *all = keyword_(dict, "allOf")) {
+      ops.push_back({Op::AllOf, 0, 0, 0, list_(*all, "allOf")});
+    }
+    if (const JObject *any = keyword_(dict, "anyOf")) {
+      ops.push_back({Op::AnyOf, 0, 0, 0, list_(*any, "anyOf")});
+    }
+    if (const JObject *one = keyword_(dict, "oneOf")) {
+      ops.push_back({Op::OneOf, 0, 0, 0, list_(*one, "oneOf")});
+    }
+    if (const JObject *negated = keyword_(dict, "not")) {
+      ops.push_back({Op::Not, 0, 0, 0, compile(*negated)});
+    }
+    return program;
+  }
+
+  void objectRules_(const dict_t &dict, std::vector<Op> &ops) {
+    const JObject *properties = keyword_(dict, "properties");
+    const JObject *required = keyword_(dict, "required");
+    const JObject *patterns = keyword_(dict, "patternProperties");
+    const JObject *additional = keyword_(dict, "additionalProperties");
+    const JObject *minProperties = keyword_(dict, "minProperties");
+    const JObject *maxProperties = keyword_(dict, "maxProperties");
+    if (!properties && !required && !patterns && !additional &&
+        !minProperties && !maxProperties) {
+      return;
+    }
+
+    ObjectRules rules;
+    if (required) {
+      if (required->getType() != JValueType::JList) {
+        throw std::logic_error("Invalid Schema: required must be a list");
+      }
+      for (const auto &name : required->getList()) {
+        if (name.getType() != JValueType::JString) {
+          throw std::logic_error(
+              "Invalid Schema: required must list strings");
+        }
+        rules.slot(name.getPMRString());
+      }
+      rules.required = rules.names.size();
+    }
+    if (properties) {
+      if (properties->getType() != JValueType::JDict) {
+        throw std::logic_error("Invalid Schema: properties must be a dict");
+      }
+      for (const auto &[name, subschema] : properties->getDict()) {
+        const std::size_t slot = rules.slot(name);
+        const std::size_t program = compile(subschema);
+        rules.schemas[slot] = program;
+      }
+    }
+    if (patterns) {
+      if (patterns->getType() != JValueType::JDict) {
+        throw std::logic_error(
+            "Invalid Schema: patternProperties must be a dict");
+      }
+      for (const auto &[source, subschema] : patterns->getDict()) {
+        const std::size_t pattern = pattern_(JObject(source));
+        rules.patterns.emplace_back(pattern, compile(subschema));
+      }
+    }
+    if (additional) {
+      if (additional->getType() == JValueType::JBool) {
+        rules.additionalForbidden = !additional->getBool();
+      } else {
+        rules.additional = compile(*additional);
+      }
+    }
+    if (minProperties) {
+      rules.minProperties = toSize_(*minProperties, "minProperties");
+    }
+    if (maxProperties) {
+      rules.maxProperties = toSize_(*maxProperties, "maxProperties");
+    }
+    ops.push_back({Op::Object, 0, 0, 0, m_validator.m_objects.size()});
+    m_validator.m_objects.push_back(std::move(rules));
+  }
+
+  static const JObject *keyword_(const dict_t &dict, std::string_view name) {
+    auto found = dict.find(name);
+    return found == dict.end() ? nullptr : &found->second;
+  }
+
+  static std::uint8_t types_(const JObject &type) {
+    auto bits = [](const JObject &name) -> std::uint8_t {
+      if (name.getType() == JValueType::JString) {
+        for (const auto &[typeName, bit] : type_names) {
+          if (name.getPMRString() == typeName) {
+            return bit;
+          }
+        }
+      }
+      throw std::logic_error("Invalid Schema: unknown type " +
+                             name.to_string());
+    };
+    if (type.getType() != JValueType::JList) {
+      return bits(type);
+    }
+    std::uint8_t result = 0;
+    for (const auto &name : type.getList()) {
+      result |= bits(name);
+    }
+    return result;
+  }
+
+  static std::size_t toSize_(const JObject &value, std::string_view name) {
+    if (!(typeBits(value) & integer_bit) || toNumber(value) < 0) {
+      throw std::logic_error("Invalid Schema: " + std::string(name) +
+                             " must be a non-negative integer");
+    }
+    return static_cast<std::size_t>(toNumber(value));
+  }
+
+  static bool number_(const dict_t &dict, std::string_view name,
+                      Op::Code code, std::vector<Op> &ops) {
+    const JObject *value = keyword_(dict, name);
+    if (!value) {
+      return false;
+    }
+    if (!isNumber(*value)) {
+      throw std::logic_error("Invalid Schema: " + std::string(name) +
+                             " must be a number");
+    }
+    ops.push_back({code, 0, toNumber(*value)});
+    return true;
+  }
+
+  static void size_(const dict_t &dict, std::string_view name, Op::Code code,
+                    std::vector<Op> &ops) {
+    if (const JObject *value = keyword_(dict, name)) {
+      ops.push_back({code, 0, 0, toSize_(*value, name)});
+    }
+  }
+
+  std::size_t pattern_(const JObject &source) {
+    if (source.getType() != JValueType::JString) {
+      throw std::logic_error("Invalid Schema: pattern must be a string");
+    }
+    const std::string text = source.getString();
+    try {
+      m_validator.m_patterns.push_back(
+          {text, std::regex(text, std::regex::ECMAScript |
+                                      std::regex::optimize)});
+    } catch (const std::regex_error &) {
+      throw std::logic_error("Invalid Schema: bad pattern " + text);
+    }
+    return m_validator.m_patterns.size() - 1;
+  }
+
+  std::size_t valueSet_(const JObject *values, std::size_t count) {
+    ValueSet set;
+    for (std::size_t i = 0; i < count; i++) {
+      set.values.emplace(jsonHash(values[i]), values[i]);
+    }
+    m_validator.m_sets.push_back(std::move(set));
+    return m_validator.m_sets.size() - 1;
+  }
+
+  std::size_t list_(const JObject &schemas, std::string_view name) {
+    if (schemas.getType() != JValueType::JList ||
+        schemas.getList().empty()) {
+      throw std::logic_error("Invalid Schema: " + std::string(name) +
+                             " must be a non-empty list");
+    }
+    std::vector<std::size_t> programs;
+    for (const auto &schema : schemas.getList()) {
+      programs.push_back(compile(schema));
+    }
+    m_validator.m_lists.push_back(std::move(programs));
+    return m_validator.m_lists.size() - 1;
+  }
+
+  /// Resolves a local reference: "#" followed by a JSON Pointer.
+  const JObject &resolve_(std::string_view ref) const {
+    if (ref.empty() || ref[0] != '#') {
+      throw std::logic_error("Unsupported $ref: " + std::string(ref));
+    }
+    std::string_view pointer = ref.substr(1);
+    const JObject *target = &m_root;
+    while (!pointer.empty()) {
+      if (pointer[0] != '/') {
+        throw std::logic_error("Unsupported $ref: " + std::string(ref));
+      }
+      pointer.remove_prefix(1);
+      const std::size_t end = std::min(pointer.find('/'), pointer.size());
+      std::string token;
+      for (std::size_t i = 0; i < end; i++) {
+        if (pointer[i] == '~' && i + 1 < end &&
+            (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+          token += pointer[++i] == '0' ? '~' : '/';
+        } else {
+          token += pointer[i];
+        }
+      }
+      pointer.remove_prefix(end);
+
+      if (target->getType() == JValueType::JDict) {
+        auto found = target->getDict().find(std::string_view(token));
+        if (found == target->getDict().end()) {
+          throw std::logic_error("Unresolvable $ref: " + std::string(ref));
+        }
+        target = &found->second;
+      } else if (target->getType() == JValueType::JList) {
+        std::size_t index = 0;
+        auto result =
+            std::from_chars(token.data(), token.data() + token.size(), index);
+        if (result.ec != std::errc() ||
+            result.ptr != token.data() + token.size() ||
+            index >= target->getList().size()) {
+          throw std::logic_error("Unresolvable $ref: " + std::string(ref));
+        }
+        target = &target->getList()[index];
+      } else {
+        throw std::logic_error("Unresolvable $ref: " + std::string(ref));
+      }
+    }
+    return *target;
+  }
+
+  JValidator &m_validator;
+  const JObject &m_root;
+  std::unordered_map<const JObject *, std::size_t> m_compiled;
+};
+
+/**
+ * @brief One validation of one document.
+ *
+ * Without an error list, every check returns at the first failure and no
+ * path is built.
+ */
+class JValidator::Run {
+public:
+  Run(const JValidator &validator, std::vector<JValidationError> *errors)
+      : m_validator(validator), m_errors(errors) {}
+
+  bool program(std::size_t index, const JObject &value) {
+    if (++m_depth > max_schema_depth) {
+      --m_depth;
+      return fail_("schema recursion too deep");
+    }
+    bool valid = true;
+    for (const Op &op : m_validator.m_programs[index].ops) {
+      if (!op_(op, value)) {
+        valid = false;
+        if (!m_errors) {
+          break;
+        }
+      }
+    }
+    --m_depth;
+    return valid;
+  }
+
+private:
+  bool op_(const Op &op, const JObject &value) {
+    switch (op.code) {
+    case Op::Fail:
+      return fail_("no value is allowed here");
+    case Op::Ref:
+      return program(op.index, value);
+    case Op::Type:
+      return (typeBits(value) & op.types) != 0 ||
+             fail_("value has the wrong type");
+    case Op::Const:
+      return m_validator.m_sets[op.index].contains(value) ||
+             fail_("value differs from const");
+    case Op::Enum:
+      return m_validator.m_sets[op.index].contains(value) ||
+             fail_("value is not in enum");
+    case Op::Minimum:
+      return !isNumber(value) || toNumber(value) >= op.number ||
+             fail_("value is below minimum " + formatNumber(op.number));
+    case Op::Maximum:
+      return !isNumber(value) || toNumber(value) <= op.number ||
+             fail_("value is above maximum " + formatNumber(op.number));
+    case Op::ExclusiveMinimum:
+      return !isNumber(value) || toNumber(value) > op.number ||
+             fail_("value is not above " + formatNumber(op.number));
+    case Op::ExclusiveMaximum:
+      return !isNumber(value) || toNumber(value) < op.number ||
+             fail_("value is not below " + formatNumber(op.number));
+    case Op::MultipleOf:
+      return !isNumber(value) || multipleOf_(toNumber(value), op.number) ||
+             fail_("value is not a multiple of " + formatNumber(op.number));
+    case Op::MinLength:
+      return value.getType() != JValueType::JString ||
+             codePoints(value.getPMRString()) >= op.size ||
+             fail_("string is shorter than " + std::to_string(op.size));
+    case Op::MaxLength:
+      return value.getType() != JValueType::JString ||
+             codePoints(value.getPMRString()) <= op.size ||
+             fail_("string is longer than " + std::to_string(op.size));
+    case Op::Pattern: {
+      if (value.getType() != JValueType::JString) {
+        return true;
+      }
+      const Pattern &pattern = m_validator.m_patterns[op.index];
+      const string_t &str = value.getPMRString();
+      return std::regex_search(str.begin(), str.end(), pattern.regex) ||
+             fail_("string does not match " + pattern.source);
+    }
+    case Op::Items:
+    case Op::PrefixItems:
+    case Op::Contains:
+    case Op::UniqueItems:
+      return value.getType() != JValueType::JList || list_(op, value);
+    case Op::MinItems:
+      return value.getType() != JValueType::JList ||
+             value.getList().size() >= op.size ||
+             fail_("list has fewer than " + std::to_string(op.size) +
+                   " items");
+    case Op::MaxItems:
+      return value.getType() != JValueType::JList ||
+             value.getList().size() <= op.size ||
+             fail_("list has more than " + std::to_string(op.size) +
+                   " items");
+    case Op::Object:
+      return value.getType() != JValueType::JDict ||
+             object_(m_validator.m_objects[op.index], value.getDict());
+    case Op::AllOf: {
+      bool valid = true;
+      for (std::size_t index : m_validator.m_lists[op.index]) {
+        if (!program(index, value)) {
+          valid = false;
+          if (!m_errors) {
+            break;
+          }
+        }
+      }
+      return valid;
+    }
+    case Op::AnyOf:
+      for (std::size_t index : m_validator.m_lists[op.index]) {
+        if (quiet_(index, value)) {
+          return true;
+        }
+      }
+      return fail_("value matches no schema in anyOf");
+    case Op::OneOf: {
+      std::size_t matches = 0;
+      for (std::size_t index : m_validator.m_lists[op.index]) {
+        if (quiet_(index, value) && ++matches > 1) {
+          break;
+        }
+      }
+      return matches == 1 ||
+             fail_(matches == 0 ? "value matches no schema in oneOf"
+                                : "value matches several schemas in oneOf");
+    }
+    case Op::Not:
+      return !quiet_(op.index, value) ||
+             fail_("value matches the schema in not");
+    }
+    return true;
+  }
+
+  bool list_(const Op &op, const JObject &value) {
+    const list_t &list = value.getList();
+    switch (op.code) {
+    case Op::PrefixItems: {
+      const auto &programs = m_validator.m_lists[op.index];
+      bool valid = true;
+      for (std::size_t i = 0; i < std::min(list.size(), programs.size());
+           i++) {
+        if (!child_(i, programs[i], list[i])) {
+          valid = false;
+          if (!m_errors) {
+            break;
+          }
+        }
+      }
+      return valid;
+    }
+    case Op::Items: {
+      bool valid = true;
+      for (std::size_t i = op.size; i < list.size(); i++) {
+        if (!child_(i, op.index, list[i])) {
+          valid = false;
+          if (!m_errors) {
+            break;
+          }
+        }
+      }
+      return valid;
+    }
+    case Op::Contains: {
+      std::size_t matches = 0;
+      const std::size_t depth = std::exchange(m_depth, 0);
+      for (const auto &item : list) {
+        matches += quiet_(op.index, item);
+      }
+      m_depth = depth;
+      if (matches < op.size) {
+        return fail_("list contains fewer than " + std::to_string(op.size) +
+                     " matching items");
+      }
+      return static_cast<double_t>(matches) <= op.number ||
+             fail_("list contains too many matching items");
+    }
+    default: {
+      // uniqueItems: hash every item, then compare equal hashes only.
+      std::vector<std::pair<std::size_t, std::size_t>> hashes;
+      hashes.reserve(list.size());
+      for (std::size_t i = 0; i < list.size(); i++) {
+        hashes.emplace_back(jsonHash(list[i]), i);
+      }
+      std::sort(hashes.begin(), hashes.end());
+      for (std::size_t i = 0; i < hashes.size(); i++) {
+        for (std::size_t j = i + 1;
+             j < hashes.size() && hashes[j].first == hashes[i].first; j++) {
+          if (jsonEqual(list[hashes[i].second], list[hashes[j].second])) {
+            return fail_("list items are not unique");
+          }
+        }
+      }
+      return true;
+    }
+    }
+  }
+
+  bool object_(const ObjectRules &rules, const dict_t &dict) {
+    bool valid = true;
+    if (dict.size() < rules.minProperties) {
+      valid = fail_("dict has fewer than " +
+                    std::to_string(rules.minProperties) + " members");
+    }
+    if (dict.size() > rules.maxProperties) {
+      valid = fail_("dict has more than " +
+                    std::to_string(rules.maxProperties) + " members");
+    }
+    if (!valid && !m_errors) {
+      return false;
+    }
+
+    std::size_t required = 0;
+    for (const auto &[key, member] : dict) {
+      bool matched = false;
+      auto found = rules.slots.find(std::string_view(key));
+      if (found != rules.slots.end()) {
+        const std::size_t slot = found->second;
+        required += slot < rules.required;
+        if (rules.schemas[slot] != none) {
+          matched = true;
+          if (!child_(key, rules.schemas[slot], member)) {
+            valid = false;
+          }
+        }
+      }
+      for (const auto &[pattern, program] : rules.patterns) {
+        if (std::regex_search(key.begin(), key.end(),
+                              m_validator.m_patterns[pattern].regex)) {
+          matched = true;
+          if (!child_(key, program, member)) {
+            valid = false;
+          }
+        }
+      }
+      if (!matched) {
+        if (rules.additionalForbidden) {
+          valid = childFail_(key, "property is not allowed");
+        } else if (rules.additional != none &&
+                   !child_(key, rules.additional, member)) {
+          valid = false;
+        }
+      }
+      if (!valid && !m_errors) {
+        return false;
+      }
+    }
+
+    if (required < rules.required) {
+      valid = false;
+      for (std::size_t slot = 0; m_errors && slot < rules.required; slot++) {
+        if (!dict.contains(std::string_view(rules.names[slot]))) {
+          fail_("required property \"" + rules.names[slot] +
+                "\" is missing");
+        }
+      }
+    }
+    return valid;
+  }
+
+  static bool multipleOf_(double_t value, double_t divisor) {
+    const double_t quotient = value / divisor;
+    if (!std::isfinite(quotient)) {
+      return false;
+    }
+    const double_t error = std::fabs(quotient - std::nearbyint(quotient));
+    return error <= 1e-9L * std::max<double_t>(1, std::fabs(quotient));
+  }
+
+  /// Checks a subschema without reporting its errors.
+  bool quiet_(std::size_t index, const JObject &value) {
+    auto *errors = std::exchange(m_errors, nullptr);
+    const bool valid = program(index, value);
+    m_errors = errors;
+    return valid;
+  }
+
+  template <class Token>
+  bool child_(const Token &token, std::size_t index, const JObject &value) {
+    const std::size_t depth = std::exchange(m_depth, 0);
+    bool valid = false;
+    if (!m_errors) {
+      valid = program(index, value);
+    } else {
+      const std::size_t length = m_path.size();
+      appendToken_(token);
+      valid = program(index, value);
+      m_path.resize(length);
+    }
+    m_depth = depth;
+    return valid;
+  }
+
+  bool childFail_(std::string_view key, std::string message) {
+    if (m_errors) {
+      const std::size_t length = m_path.size();
+      appendToken_(key);
+      fail_(std::move(message));
+      m_path.resize(length);
+    }
+    return false;
+  }
+
+  void appendToken_(std::size_t index) {
+    m_path += '/';
+    m_path += std::to_string(index);
+  }
+  void appendToken_(std::string_view key) { appendPointerToken(m_path, key); }
+
+  bool fail_(std::string message) {
+    if (m_errors) {
+      m_errors->push_back({m_path, std::move(message)});
+    }
+    return false;
+  }
+
+  const JValidator &m_validator;
+  std::vector<JValidationError> *m_errors;
+  std::string m_path;
+  std::size_t m_depth = 0;
+};
+
+JValidator::JValidator() { m_programs.emplace_back(); }
+
+JValidator::JValidator(JValidator &&validator) noexcept = default;
+
+JValidator::~JValidator() = default;
+
+JValidator &JValidator::operator=(JValidator &&validator) noexcept = default;
+
+JValidator JValidator::compile(const JObject &schema) {
+  JValidator validator;
+  validator.m_programs.clear();
+  Compiler(validator, schema).compile(schema);
+  return validator;
+}
+
+bool JValidator::validate(const JObject &document) const {
+  return Run(*this, nullptr).program(0, document);
+}
+
+bool JValidator::validate(const JObject &document,
+                          std::vector<JValidationError> &errors) const {
+  errors.clear();
+  return Run(*this, &errors).program(0, document);
+}
+
+JSON_NAMESPACE_END
@@ -0,0 +1,91 @@
+#ifndef JSON_VALIDATOR_HPP
+#define JSON_VALIDATOR_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.h"
+
+namespace qjson {
+/**
+ * @brief One way in which a document breaks its schema.
+ */
+struct JValidationError {
+  std::string path;    ///< JSON Pointer to the offending value.
+  std::string message; ///< What is wrong with it.
+};
+
+/**
+ * @brief JSON Schema validator compiled ahead of time.
+ *
+ * compile() turns a schema into a table of small programs, one per
+ * subschema, whose instructions each check one keyword. Everything that
+ * can be prepared is prepared then: patterns are compiled regexes, enum
+ * and const values sit in a hash set, property names map to slots, and
+ * local $ref pointers are resolved to program indices (recursive schemas
+ * included). Validating a document walks it once, building error paths
+ * only when errors are collected.
+ *
+ * Supported keywords: type, enum, const, minimum, maximum,
+ * exclusiveMinimum, exclusiveMaximum, multipleOf, minLength, maxLength,
+ * pattern, items, prefixItems, contains, minItems, maxItems, uniqueItems,
+ * properties, required, additionalProperties, patternProperties,
+ * minProperties, maxProperties, allOf, anyOf, oneOf, not and local $ref
+ * ("#", "#/$defs/...", any JSON Pointer into the schema). Other keywords
+ * are ignored. Numbers compare by value, so 1 and 1.0 are equal, and a
+ * double with no fractional part is an integer.
+ */
+class JValidator {
+public:
+  /// A validator accepting everything, as the schema `true` does.
+  JValidator();
+  JValidator(JValidator &&validator) noexcept;
+  ~JValidator();
+
+  JValidator &operator=(JValidator &&validator) noexcept;
+
+  /**
+   * @brief Compiles a schema.
+   * @param schema The schema, a dict or a bool.
+   * @return The validator.
+   * @throw std::logic_error If the schema is malformed, a pattern does not
+   * compile, or a $ref cannot be resolved.
+   */
+  static JValidator compile(const JObject &schema);
+
+  /**
+   * @brief Checks a document, stopping at the first error.
+   * @return true if the document is valid.
+   */
+  bool validate(const JObject &document) const;
+
+  /**
+   * @brief Checks a document and lists every error found.
+   * @param document The document to check.
+   * @param errors Receives the errors; it is cleared first.
+   * @return true if the document is valid.
+   */
+  bool validate(const JObject &document,
+                std::vector<JValidationError> &errors) const;
+
+private:
+  struct Op;
+  struct Program;
+  struct Pattern;
+  struct ValueSet;
+  struct ObjectRules;
+  class Compiler;
+  class Run;
+
+  std::vector<Program> m_programs; ///< m_programs[0] is the root schema.
+  std::vector<Pattern> m_patterns;
+  std::vector<ValueSet> m_sets; ///< enum and const values.
+  std::vector<ObjectRules> m_objects;
+  /// Subschemas of allOf, anyOf, oneOf and prefixItems.
+  std::vector<std::vector<std::size_t>> m_lists;
+};
+} // namespace qjson
+
+#endif // !JSON_VALIDATOR_HPP
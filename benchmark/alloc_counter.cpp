@@ -0,0 +1,87 @@
+#include "alloc_counter.h"
+#include <cstdlib>
+#include <new>
+
+// Replacement global operator new and delete, counting into the totals
+// read by HeapCounter. Each block carries its size in a header so that
+// unsized deletes can update the live bytes.
+
+namespace {
+constexpr std::size_t header = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+std::atomic<std::size_t> g_allocations{0};
+std::atomic<std::size_t> g_bytes{0};
+std::atomic<std::size_t> g_live{0};
+std::atomic<std::size_t> g_peak{0};
+
+void *count_allocate(std::size_t size) noexcept {
+  void *block = std::malloc(header + size);
+  if (block == nullptr)
+    return nullptr;
+  *static_cast<std::size_t *>(block) = size;
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(size, std::memory_order_relaxed);
+  const std::size_t live =
+      g_live.fetch_add(size, std::memory_order_relaxed) + size;
+  std::size_t peak = g_peak.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !g_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    ;
+  return static_cast<char *>(block) + header;
+}
+
+void *count_new(std::size_t size) {
+  for (;;) {
+    if (void *p = count_allocate(size))
+      return p;
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void count_delete(void *p) noexcept {
+  if (p == nullptr)
+    return;
+  void *block = static_cast<char *>(p) - header;
+  g_live.fetch_sub(*static_cast<std::size_t *>(block),
+                   std::memory_order_relaxed);
+  std::free(block);
+}
+} // namespace
+
+void *operator new(std::size_t size) { return count_new(size); }
+void *operator new[](std::size_t size) { return count_new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return count_allocate(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return count_allocate(size);
+}
+
+void operator delete(void *p) noexcept { count_delete(p); }
+void operator delete[](void *p) noexcept { count_delete(p); }
+void operator delete(void *p, std::size_t) noexcept { count_delete(p); }
+void operator delete[](void *p, std::size_t) noexcept { count_delete(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  count_delete(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  count_delete(p);
+}
+
+HeapCounter::HeapCounter() noexcept
+    : m_allocations(g_allocations.load(std::memory_order_relaxed)),
+      m_bytes(g_bytes.load(std::memory_order_relaxed)),
+      m_live(g_live.load(std::memory_order_relaxed)) {
+  g_peak.store(m_live, std::memory_order_relaxed);
+}
+
+void HeapCounter::report(benchmark::State &state) const {
+  const std::size_t peak = g_peak.load(std::memory_order_relaxed);
+  report_allocations(
+      state, g_allocations.load(std::memory_order_relaxed) - m_allocations,
+      g_bytes.load(std::memory_order_relaxed) - m_bytes,
+      peak > m_live ? peak - m_live : 0);
+}
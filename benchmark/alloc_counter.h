@@ -0,0 +1,146 @@
+#ifndef BENCHMARK_ALLOC_COUNTER_HPP
+#define BENCHMARK_ALLOC_COUNTER_HPP
+
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @brief Memory resource counting what it forwards to its upstream.
+ *
+ * Counters are atomic so the resource can serve several benchmark
+ * threads at once.
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+  explicit CountingResource(
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : m_upstream(upstream) {}
+
+  std::size_t allocations() const noexcept {
+    return m_allocations.load(std::memory_order_relaxed);
+  }
+  std::size_t bytes() const noexcept {
+    return m_bytes.load(std::memory_order_relaxed);
+  }
+  /// Bytes allocated and not yet released.
+  std::size_t live() const noexcept {
+    return m_live.load(std::memory_order_relaxed);
+  }
+  /// Highest number of bytes allocated and not yet released.
+  std::size_t peak() const noexcept {
+    return m_peak.load(std::memory_order_relaxed);
+  }
+
+private:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void *p = m_upstream->allocate(bytes, alignment);
+    m_allocations.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    const std::size_t live =
+        m_live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    std::size_t peak = m_peak.load(std::memory_order_relaxed);
+    while (live > peak &&
+           !m_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+      ;
+    return p;
+  }
+
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override {
+    m_upstream->deallocate(p, bytes, alignment);
+    m_live.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource *m_upstream;
+  std::atomic<std::size_t> m_allocations{0};
+  std::atomic<std::size_t> m_bytes{0};
+  std::atomic<std::size_t> m_live{0};
+  std::atomic<std::size_t> m_peak{0};
+};
+
+/**
+ * @brief Adds allocs/iter, bytes/iter and peak_bytes to the results.
+ */
+inline void report_allocations(benchmark::State &state,
+                               std::size_t allocations, std::size_t bytes,
+                               std::size_t peak) {
+  using benchmark::Counter;
+  state.counters["allocs/iter"] =
+      Counter(static_cast<double>(allocations), Counter::kAvgIterations);
+  state.counters["bytes/iter"] =
+      Counter(static_cast<double>(bytes), Counter::kAvgIterations,
+              Counter::kIs1024);
+  state.counters["peak_bytes"] = Counter(
+      static_cast<double>(peak), Counter::kDefaults, Counter::kIs1024);
+}
+
+/**
+ * @brief Makes a CountingResource the default memory resource while in
+ * scope, and reports it as benchmark counters.
+ *
+ * Create it after the benchmark's setup so that only the timed loop is
+ * counted. Memory allocated before keeps going back to its own resource.
+ * Only pmr allocations are seen; JObject uses them throughout, while
+ * std::string results and the INI containers use the global heap.
+ */
+class AllocationCounter {
+public:
+  AllocationCounter()
+      : m_previous(std::pmr::set_default_resource(&m_resource)) {}
+  ~AllocationCounter() { std::pmr::set_default_resource(m_previous); }
+
+  AllocationCounter(const AllocationCounter &) = delete;
+  AllocationCounter &operator=(const AllocationCounter &) = delete;
+
+  const CountingResource &resource() const noexcept { return m_resource; }
+
+  /**
+   * @brief Adds allocs/iter, bytes/iter and peak_bytes to the results.
+   */
+  void report(benchmark::State &state) const {
+    report_allocations(state, m_resource.allocations(), m_resource.bytes(),
+                       m_resource.peak());
+  }
+
+private:
+  CountingResource m_resource;
+  std::pmr::memory_resource *m_previous;
+};
+
+/**
+ * @brief Counts global operator new calls from construction on, and
+ * reports them as benchmark counters.
+ *
+ * This sees what AllocationCounter does not: std::string results, the INI
+ * containers, and pmr allocations that end up on the global heap.
+ * Over-aligned allocations are not counted. The replacement operators live
+ * in alloc_counter.cpp, which every binary using this class must link.
+ */
+class HeapCounter {
+public:
+  /// Also lowers the recorded peak to the bytes live now.
+  HeapCounter() noexcept;
+
+  HeapCounter(const HeapCounter &) = delete;
+  HeapCounter &operator=(const HeapCounter &) = delete;
+
+  /**
+   * @brief Adds allocs/iter, bytes/iter and peak_bytes to the results;
+   * the peak is counted above the bytes live at construction.
+   */
+  void report(benchmark::State &state) const;
+
+private:
+  std::size_t m_allocations;
+  std::size_t m_bytes;
+  std::size_t m_live;
+};
+
+#endif // !BENCHMARK_ALLOC_COUNTER_HPP
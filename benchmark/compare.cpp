@@ -0,0 +1,396 @@
+// Stores benchmark results as named baselines and compares runs.
+//
+//   bench_compare [options] run <name> <executable> [benchmark flags...]
+//       Runs a Google Benchmark executable (with 5 repetitions unless the
+//       flags say otherwise) and saves its JSON output as baseline <name>.
+//   bench_compare [options] compare <baseline> <candidate>
+//       Compares two saved runs; each is a baseline name or a JSON file
+//       written with --benchmark_out.
+//   bench_compare [options] list
+//
+// Options:
+//   --dir=PATH       where baselines live (default: bench-baselines)
+//   --against=NAME   with `run`, compare the new run against NAME
+//   --metric=real|cpu   which time to compare (default: real)
+//   --threshold=PCT  smallest change worth reporting (default: 5)
+//   --alpha=P        significance level of the rank test (default: 0.05)
+//
+// For every benchmark present in both runs, the repetitions of each side
+// are compared with a two-sided Mann-Whitney U test. A benchmark counts
+// as regressed when its median time grew by more than the threshold and
+// the test rejects "same distribution" at the given level. Only the
+// threshold is applied when either side has fewer than three repetitions,
+// or when even fully separated runs could not reach the level: with three
+// per side the smallest p is about 0.08, so at the default level each side
+// needs four or more for the test to count. The exit status is 1 if
+// anything regressed, so the tool can gate a CI job.
+#include "../Json.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+struct Options {
+  fs::path dir = "bench-baselines";
+  std::string against;
+  bool cpuTime = false;
+  double threshold = 5;
+  double alpha = 0.05;
+};
+
+/// Repetition times of one benchmark, in nanoseconds, in run order.
+using Runs = std::map<std::string, std::vector<double>>;
+
+struct Comparison {
+  std::string name;
+  double baseline;  ///< Median, ns.
+  double candidate; ///< Median, ns.
+  double change;    ///< Relative change of the median.
+  double pValue;    ///< NaN when there were too few repetitions.
+  bool regressed;
+  bool improved;
+};
+
+void usage() {
+  std::fputs(
+      "usage: bench_compare [options] run <name> <executable> [flags...]\n"
+      "       bench_compare [options] compare <baseline> <candidate>\n"
+      "       bench_compare [options] list\n"
+      "options: --dir=PATH --against=NAME --metric=real|cpu"
+      " --threshold=PCT --alpha=P\n",
+      stderr);
+}
+
+double parse_double(std::string_view arg, std::string_view value) {
+  const std::string text(value);
+  char *end = nullptr;
+  const double parsed = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0')
+    throw std::runtime_error("bad value in " + std::string(arg));
+  return parsed;
+}
+
+double to_double(const qjson::JObject &jobject) {
+  if (jobject.getType() == qjson::JInt)
+    return static_cast<double>(jobject.getInt());
+  if (jobject.getType() == qjson::JDouble)
+    return static_cast<double>(jobject.getDouble());
+  throw std::runtime_error("expected a number");
+}
+
+double to_nanoseconds(double value, std::string_view unit) {
+  if (unit == "ns")
+    return value;
+  if (unit == "us")
+    return value * 1e3;
+  if (unit == "ms")
+    return value * 1e6;
+  if (unit == "s")
+    return value * 1e9;
+  throw std::runtime_error("unknown time unit " + std::string(unit));
+}
+
+std::string read_file(const fs::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("cannot open " + path.string());
+  std::ostringstream buffer;
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+fs::path baseline_path(const Options &options, const std::string &name) {
+  return options.dir / (name + ".json");
+}
+
+// A name is looked up among the baselines first, then taken as a path.
+fs::path resolve(const Options &options, const std::string &nameOrPath) {
+  const fs::path stored = baseline_path(options, nameOrPath);
+  if (fs::exists(stored))
+    return stored;
+  if (fs::exists(nameOrPath))
+    return nameOrPath;
+  throw std::runtime_error("no baseline or file named " + nameOrPath);
+}
+
+Runs load_runs(const fs::path &path, bool cpuTime) {
+  const qjson::JObject document = qjson::to_json(read_file(path));
+  const auto &root = document.getDict();
+  const auto benchmarks = root.find("benchmarks");
+  if (benchmarks == root.end())
+    throw std::runtime_error(path.string() + " has no \"benchmarks\"");
+
+  Runs runs;
+  for (const auto &entry : benchmarks->second.getList()) {
+    const auto &fields = entry.getDict();
+    const auto runType = fields.find("run_type");
+    if (runType != fields.end() &&
+        runType->second.getPMRString() == "aggregate")
+      continue;
+    if (fields.contains("error_occurred") &&
+        fields.find("error_occurred")->second.getBool())
+      continue;
+    const auto name = fields.find(fields.contains("run_name") ? "run_name"
+                                                              : "name");
+    const auto time = fields.find(cpuTime ? "cpu_time" : "real_time");
+    const auto unit = fields.find("time_unit");
+    if (name == fields.end() || time == fields.end() ||
+        unit == fields.end())
+      throw std::runtime_error(path.string() +
+                               ": benchmark entry without name or time");
+    runs[name->second.getString()].push_back(
+        to_nanoseconds(to_double(time->second),
+                       unit->second.getPMRString()));
+  }
+  return runs;
+}
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  const std::size_t middle = values.size() / 2;
+  return values.size() % 2 ? values[middle]
+                           : (values[middle - 1] + values[middle]) / 2;
+}
+
+/**
+ * @brief Two-sided Mann-Whitney U test, normal approximation with tie
+ * correction. Returns NaN if either side has fewer than three values.
+ */
+double mann_whitney(const std::vector<double> &a,
+                    const std::vector<double> &b) {
+  const std::size_t n1 = a.size();
+  const std::size_t n2 = b.size();
+  if (n1 < 3 || n2 < 3)
+    return std::nan("");
+
+  std::vector<std::pair<double, bool>> all;
+  for (double value : a)
+    all.emplace_back(value, true);
+  for (double value : b)
+    all.emplace_back(value, false);
+  std::sort(all.begin(), all.end());
+
+  const double n = static_cast<double>(n1 + n2);
+  double rankSumA = 0;
+  double tieTerm = 0;
+  for (std::size_t i = 0; i < all.size();) {
+    std::size_t j = i;
+    while (j < all.size() && all[j].first == all[i].first)
+      j++;
+    const double rank = (static_cast<double>(i + j) + 1) / 2;
+    const double ties = static_cast<double>(j - i);
+    tieTerm += ties * ties * ties - ties;
+    for (std::size_t k = i; k < j; k++)
+      if (all[k].second)
+        rankSumA += rank;
+    i = j;
+  }
+
+  const double u = rankSumA - static_cast<double>(n1 * (n1 + 1)) / 2;
+  const double mean = static_cast<double>(n1 * n2) / 2;
+  const double variance = static_cast<double>(n1 * n2) / 12 *
+                          ((n + 1) - tieTerm / (n * (n - 1)));
+  if (variance <= 0)
+    return 1;
+  const double z = (std::abs(u - mean) - 0.5) / std::sqrt(variance);
+  return std::erfc(std::max(z, 0.0) / std::sqrt(2.0));
+}
+
+/**
+ * @brief Smallest p-value mann_whitney() can return for these sample
+ * sizes, reached when the two sides do not overlap and have no ties.
+ */
+double min_p_value(std::size_t n1, std::size_t n2) {
+  const double n = static_cast<double>(n1 + n2);
+  const double mean = static_cast<double>(n1 * n2) / 2;
+  const double variance = static_cast<double>(n1 * n2) / 12 * (n + 1);
+  const double z = (mean - 0.5) / std::sqrt(variance);
+  return std::erfc(z / std::sqrt(2.0));
+}
+
+std::vector<Comparison> compare(const Options &options, const Runs &baseline,
+                                const Runs &candidate) {
+  std::vector<Comparison> result;
+  for (const auto &[name, before] : baseline) {
+    const auto found = candidate.find(name);
+    if (found == candidate.end())
+      continue;
+    const auto &after = found->second;
+    Comparison comparison{name, median(before), median(after), 0,
+                          mann_whitney(before, after), false, false};
+    if (comparison.baseline > 0)
+      comparison.change = comparison.candidate / comparison.baseline - 1;
+    // A test that cannot reject at this level would hide every change, so
+    // then only the threshold applies.
+    const bool testable =
+        !std::isnan(comparison.pValue) &&
+        min_p_value(before.size(), after.size()) < options.alpha;
+    const bool significant =
+        !testable || comparison.pValue < options.alpha;
+    const double threshold = options.threshold / 100;
+    comparison.regressed = significant && comparison.change > threshold;
+    comparison.improved = significant && comparison.change < -threshold;
+    result.push_back(std::move(comparison));
+  }
+  return result;
+}
+
+std::string format_time(double ns) {
+  constexpr const char *units[] = {"ns", "us", "ms", "s"};
+  std::size_t unit = 0;
+  while (ns >= 1000 && unit + 1 < std::size(units)) {
+    ns /= 1000;
+    unit++;
+  }
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.3g %s", ns, units[unit]);
+  return buffer;
+}
+
+int report(const std::vector<Comparison> &comparisons) {
+  std::size_t width = 9;
+  for (const auto &comparison : comparisons)
+    width = std::max(width, comparison.name.size());
+  std::printf("%-*s %12s %12s %9s %8s\n", static_cast<int>(width),
+              "benchmark", "baseline", "candidate", "change", "p");
+  std::size_t regressions = 0;
+  std::size_t improvements = 0;
+  for (const auto &comparison : comparisons) {
+    char pValue[16] = "-";
+    if (!std::isnan(comparison.pValue))
+      std::snprintf(pValue, sizeof(pValue), "%.3f", comparison.pValue);
+    std::printf("%-*s %12s %12s %+8.1f%% %8s%s\n", static_cast<int>(width),
+                comparison.name.c_str(),
+                format_time(comparison.baseline).c_str(),
+                format_time(comparison.candidate).c_str(),
+                comparison.change * 100, pValue,
+                comparison.regressed  ? "  REGRESSION"
+                : comparison.improved ? "  improved"
+                                      : "");
+    regressions += comparison.regressed;
+    improvements += comparison.improved;
+  }
+  std::printf("%zu compared, %zu regressed, %zu improved\n",
+              comparisons.size(), regressions, improvements);
+  return regressions == 0 ? 0 : 1;
+}
+
+std::string shell_quote(std::string_view arg) {
+  std::string quoted = "'";
+  for (char c : arg) {
+    if (c == '\'')
+      quoted += "'\\''";
+    else
+      quoted += c;
+  }
+  return quoted + "'";
+}
+
+int run(const Options &options, const std::vector<std::string> &args) {
+  if (args.size() < 2) {
+    usage();
+    return 2;
+  }
+  const std::string &name = args[0];
+  fs::create_directories(options.dir);
+  const fs::path out = baseline_path(options, name);
+
+  std::string command = shell_quote(args[1]);
+  bool repetitions = false;
+  for (std::size_t i = 2; i < args.size(); i++) {
+    repetitions |= args[i].starts_with("--benchmark_repetitions");
+    command += ' ' + shell_quote(args[i]);
+  }
+  if (!repetitions)
+    command += " --benchmark_repetitions=5";
+  command += " --benchmark_out_format=json --benchmark_out=" +
+             shell_quote(out.string());
+
+  std::fflush(stdout);
+  if (std::system(command.c_str()) != 0)
+    throw std::runtime_error("benchmark run failed: " + command);
+  std::printf("saved %s\n", out.string().c_str());
+
+  if (options.against.empty())
+    return 0;
+  return report(compare(options,
+                        load_runs(resolve(options, options.against),
+                                  options.cpuTime),
+                        load_runs(out, options.cpuTime)));
+}
+
+int list(const Options &options) {
+  if (!fs::exists(options.dir))
+    return 0;
+  std::vector<std::string> names;
+  for (const auto &entry : fs::directory_iterator(options.dir))
+    if (entry.path().extension() == ".json")
+      names.push_back(entry.path().stem().string());
+  std::sort(names.begin(), names.end());
+  for (const auto &name : names)
+    std::puts(name.c_str());
+  return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    Options options;
+    int i = 1;
+    for (; i < argc; i++) {
+      const std::string_view arg = argv[i];
+      if (!arg.starts_with("--"))
+        break;
+      const std::size_t equals = arg.find('=');
+      const std::string_view key = arg.substr(0, equals);
+      const std::string_view value =
+          equals == std::string_view::npos ? "" : arg.substr(equals + 1);
+      if (key == "--dir")
+        options.dir = std::string(value);
+      else if (key == "--against")
+        options.against = value;
+      else if (key == "--metric" && (value == "real" || value == "cpu"))
+        options.cpuTime = value == "cpu";
+      else if (key == "--threshold")
+        options.threshold = parse_double(arg, value);
+      else if (key == "--alpha")
+        options.alpha = parse_double(arg, value);
+      else {
+        usage();
+        return 2;
+      }
+    }
+    if (i >= argc) {
+      usage();
+      return 2;
+    }
+
+    const std::string_view command = argv[i];
+    const std::vector<std::string> args(argv + i + 1, argv + argc);
+    if (command == "run")
+      return run(options, args);
+    if (command == "list")
+      return list(options);
+    if (command == "compare" && args.size() == 2)
+      return report(compare(
+          options, load_runs(resolve(options, args[0]), options.cpuTime),
+          load_runs(resolve(options, args[1]), options.cpuTime)));
+    usage();
+    return 2;
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "bench_compare: %s\n", e.what());
+    return 2;
+  }
+}
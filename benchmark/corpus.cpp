@@ -0,0 +1,380 @@
+#include "corpus.h"
+
+#include <array>
+#include <string_view>
+
+namespace corpus {
+namespace {
+using qjson::JObject;
+
+// Raw UTF-8 bytes, so the sources don't depend on the compiler's charset.
+constexpr std::array<std::string_view, 24> words = {
+    "the",    "quick",  "brown",  "fox",    "jumps",   "over",
+    "lazy",   "dog",    "service", "deploy", "latency", "cache",
+    "caf\xc3\xa9",                            // café
+    "na\xc3\xafve",                           // naïve
+    "\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf", // こんにちは
+    "\xe4\xb8\x96\xe7\x95\x8c",               // 世界
+    "\xe6\x9d\xb1\xe4\xba\xac",               // 東京
+    "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", // Привет
+    "\xd0\xbc\xd0\xb8\xd1\x80",               // мир
+    "\xce\xb1\xce\xb2\xce\xb3",               // αβγ
+    "\xf0\x9f\x98\x80",                       // 😀
+    "\xf0\x9f\x9a\x80",                       // 🚀
+    "\xe2\x9c\x93",                           // ✓
+    "\xd8\xb3\xd9\x84\xd8\xa7\xd9\x85",       // سلام
+};
+
+constexpr std::array<std::string_view, 10> escape_pieces = {
+    "say \"hello\" ",
+    "C:\\Program Files\\app\\bin ",
+    "line one\nline two\n",
+    "\tindented\tcolumns\t",
+    "windows\r\nline ",
+    "\b\f",
+    "</script><script>alert(\"x\")</script>",
+    "regex ^\\d+\\.\\d*$ ",
+    "json {\"nested\": \"quoted\"} ",
+    "path/to/resource ",
+};
+
+JObject string_of(std::string_view value) { return JObject(value); }
+
+JObject integer(std::uint64_t value) {
+  return JObject(static_cast<qjson::int_t>(value));
+}
+
+std::string sentence(Random &random, std::size_t wordCount) {
+  std::string text;
+  for (std::size_t i = 0; i < wordCount; i++) {
+    if (i != 0)
+      text += ' ';
+    text += words[random.below(words.size())];
+  }
+  return text;
+}
+
+JObject deep_chain(Random &random, std::size_t depth) {
+  JObject node(qjson::JDict);
+  node["leaf"] = true;
+  node["value"] = random.real(-1000, 1000);
+  for (std::size_t level = depth; level-- > 0;) {
+    if (level % 2 == 0) {
+      JObject dict(qjson::JDict);
+      dict["level"] = integer(level);
+      dict["name"] = string_of("node-" + std::to_string(level));
+      dict["child"] = std::move(node);
+      node = std::move(dict);
+    } else {
+      JObject list(qjson::JList);
+      list.push_back(integer(level));
+      list.push_back(std::move(node));
+      list.push_back(random.chance(50));
+      node = std::move(list);
+    }
+  }
+  return node;
+}
+
+JObject deep(Random &random, std::size_t count) {
+  JObject chains(qjson::JList);
+  for (std::size_t i = 0; i < count; i++)
+    chains.push_back(deep_chain(random, 64));
+  JObject document(qjson::JDict);
+  document["chains"] = std::move(chains);
+  return document;
+}
+
+JObject wide_array(Random &random, std::size_t count) {
+  JObject ints(qjson::JList);
+  JObject doubles(qjson::JList);
+  JObject mixed(qjson::JList);
+  for (std::size_t i = 0; i < count; i++) {
+    ints.push_back(integer(random.below(1000000000)));
+    doubles.push_back(random.real(-100000, 100000, 4));
+    switch (random.below(5)) {
+    case 0:
+      mixed.push_back(integer(random.below(100)));
+      break;
+    case 1:
+      mixed.push_back(random.real(0, 1));
+      break;
+    case 2:
+      mixed.push_back(string_of(words[random.below(words.size())]));
+      break;
+    case 3:
+      mixed.push_back(random.chance(50));
+      break;
+    default:
+      mixed.push_back(JObject());
+      break;
+    }
+  }
+  JObject document(qjson::JDict);
+  document["ints"] = std::move(ints);
+  document["doubles"] = std::move(doubles);
+  document["mixed"] = std::move(mixed);
+  return document;
+}
+
+JObject telemetry(Random &random, std::size_t count) {
+  constexpr std::array<std::string_view, 6> metrics = {
+      "cpu.load", "mem.used", "disk.io", "net.rx", "net.tx", "temp"};
+  constexpr std::array<std::string_view, 4> regions = {
+      "eu-west", "us-east", "ap-south", "sa-east"};
+
+  JObject records(qjson::JList);
+  for (std::size_t i = 0; i < count; i++) {
+    JObject record(qjson::JDict);
+    record["ts"] = integer(1700000000000ULL + i * 1000 + random.below(1000));
+    record["host"] = string_of("node-" + std::to_string(random.below(512)));
+    record["metric"] = string_of(metrics[random.below(metrics.size())]);
+    record["value"] = random.real(0, 10000, 4);
+
+    JObject cpu(qjson::JDict);
+    cpu["user"] = random.real(0, 100);
+    cpu["system"] = random.real(0, 100);
+    cpu["idle"] = random.real(0, 100);
+    cpu["iowait"] = random.real(0, 10);
+    record["cpu"] = std::move(cpu);
+
+    JObject samples(qjson::JList);
+    for (int k = 0; k < 8; k++)
+      samples.push_back(random.real(-50, 150, 5));
+    record["samples"] = std::move(samples);
+
+    JObject tags(qjson::JDict);
+    tags["region"] = string_of(regions[random.below(regions.size())]);
+    tags["rack"] = integer(random.below(64));
+    record["tags"] = std::move(tags);
+    records.push_back(std::move(record));
+  }
+
+  JObject document(qjson::JDict);
+  document["source"] = string_of("collector-1");
+  document["records"] = std::move(records);
+  return document;
+}
+
+JObject twitter_user(Random &random) {
+  JObject user(qjson::JDict);
+  const std::uint64_t id = 10000000 + random.below(900000000);
+  user["id"] = integer(id);
+  user["id_str"] = string_of(std::to_string(id));
+  user["name"] = string_of(sentence(random, 2));
+  user["screen_name"] = string_of("user_" + std::to_string(id % 100000));
+  user["location"] =
+      random.chance(30) ? JObject() : string_of(sentence(random, 2));
+  user["description"] = string_of(sentence(random, 12));
+  user["url"] = random.chance(50)
+                    ? JObject()
+                    : string_of("https://example.com/u/" + std::to_string(id));
+  user["followers_count"] = integer(random.below(5000000));
+  user["friends_count"] = integer(random.below(5000));
+  user["verified"] = random.chance(5);
+  user["profile_image_url"] = string_of(
+      "https://pbs.example.com/profile_images/" + std::to_string(id) +
+      "/normal.jpg");
+  return user;
+}
+
+JObject twitter(Random &random, std::size_t count) {
+  constexpr std::array<std::string_view, 5> languages = {"en", "ja", "ru",
+                                                         "es", "ar"};
+  JObject statuses(qjson::JList);
+  for (std::size_t i = 0; i < count; i++) {
+    JObject status(qjson::JDict);
+    const std::uint64_t id = 1200000000000000000ULL + i * 7919;
+    status["id"] = integer(id);
+    status["id_str"] = string_of(std::to_string(id));
+    status["created_at"] = string_of("Mon Sep 24 03:35:21 +0000 2012");
+    status["text"] = string_of(sentence(random, 8 + random.below(16)));
+    status["source"] = string_of(
+        "<a href=\"https://example.com/app\" rel=\"nofollow\">App</a>");
+    status["truncated"] = false;
+    status["in_reply_to_status_id"] =
+        random.chance(20) ? integer(id - random.below(100000)) : JObject();
+    status["user"] = twitter_user(random);
+
+    JObject entities(qjson::JDict);
+    JObject hashtags(qjson::JList);
+    for (std::uint64_t k = random.below(4); k > 0; k--) {
+      JObject hashtag(qjson::JDict);
+      hashtag["text"] = string_of(words[random.below(words.size())]);
+      JObject indices(qjson::JList);
+      const std::uint64_t start = random.below(100);
+      indices.push_back(integer(start));
+      indices.push_back(integer(start + 6));
+      hashtag["indices"] = std::move(indices);
+      hashtags.push_back(std::move(hashtag));
+    }
+    entities["hashtags"] = std::move(hashtags);
+    entities["urls"] = JObject(qjson::JList);
+    JObject mentions(qjson::JList);
+    if (random.chance(40)) {
+      JObject mention(qjson::JDict);
+      mention["screen_name"] =
+          string_of("user_" + std::to_string(random.below(100000)));
+      mention["id"] = integer(random.below(900000000));
+      mentions.push_back(std::move(mention));
+    }
+    entities["user_mentions"] = std::move(mentions);
+    status["entities"] = std::move(entities);
+
+    status["retweet_count"] = integer(random.below(10000));
+    status["favorite_count"] = integer(random.below(50000));
+    status["favorited"] = false;
+    status["retweeted"] = random.chance(10);
+    status["geo"] = JObject();
+    status["lang"] = string_of(languages[random.below(languages.size())]);
+    statuses.push_back(std::move(status));
+  }
+
+  JObject metadata(qjson::JDict);
+  metadata["completed_in"] = 0.087;
+  metadata["count"] = integer(count);
+  metadata["query"] = string_of("%23benchmark");
+
+  JObject document(qjson::JDict);
+  document["statuses"] = std::move(statuses);
+  document["search_metadata"] = std::move(metadata);
+  return document;
+}
+
+JObject escapes(Random &random, std::size_t count) {
+  JObject lines(qjson::JList);
+  for (std::size_t i = 0; i < count; i++) {
+    std::string line;
+    for (std::uint64_t k = 4 + random.below(5); k > 0; k--)
+      line += escape_pieces[random.below(escape_pieces.size())];
+    lines.push_back(string_of(line));
+  }
+  JObject document(qjson::JDict);
+  document["lines"] = std::move(lines);
+  return document;
+}
+
+JObject tiny(Random &random, std::uint64_t sequence) {
+  constexpr std::array<std::string_view, 4> ops = {"get", "set", "del",
+                                                   "ping"};
+  JObject message(qjson::JDict);
+  const std::string_view op = ops[random.below(ops.size())];
+  message["op"] = string_of(op);
+  message["seq"] = integer(sequence);
+  if (op != "ping")
+    message["key"] = string_of("user:" + std::to_string(random.below(100000)));
+  if (op == "set")
+    message["value"] = integer(random.below(1000000));
+  message["ok"] = true;
+  return message;
+}
+
+JObject api_item(Random &random) {
+  JObject item(qjson::JDict);
+  item["sku"] = string_of("sku-" + std::to_string(random.below(1000000)));
+  item["title"] = string_of(sentence(random, 2 + random.below(4)));
+  item["qty"] = integer(1 + random.below(20));
+  item["price"] = random.real(0, 500, 2);
+  item["gift"] = random.chance(10);
+  return item;
+}
+
+std::string api_message(Random &random, std::uint64_t sequence,
+                        std::size_t targetBytes) {
+  JObject message(qjson::JDict);
+  message["id"] = integer(sequence);
+  message["method"] = string_of(random.chance(70) ? "order.update"
+                                                  : "order.create");
+  message["client"] =
+      string_of("svc-" + std::to_string(random.below(64)) + "/1.4.2");
+  message["trace"] = string_of(std::to_string(random.next()));
+  std::size_t bytes = message.to_string().size() + 12;
+
+  JObject items(qjson::JList);
+  while (bytes < targetBytes) {
+    JObject item = api_item(random);
+    bytes += item.to_string().size() + 1;
+    items.push_back(std::move(item));
+  }
+  message["items"] = std::move(items);
+  return message.to_string();
+}
+} // namespace
+
+JObject generate(Shape shape, std::size_t count, std::uint64_t seed) {
+  Random random(seed);
+  switch (shape) {
+  case Shape::Deep:
+    return deep(random, count);
+  case Shape::WideArray:
+    return wide_array(random, count);
+  case Shape::Telemetry:
+    return telemetry(random, count);
+  case Shape::Twitter:
+    return twitter(random, count);
+  case Shape::Escapes:
+    return escapes(random, count);
+  case Shape::Tiny:
+  default: {
+    JObject messages(qjson::JList);
+    for (std::size_t i = 0; i < count; i++)
+      messages.push_back(tiny(random, i));
+    return messages;
+  }
+  }
+}
+
+std::vector<std::string> tiny_messages(std::size_t count, std::uint64_t seed) {
+  Random random(seed);
+  std::vector<std::string> messages;
+  messages.reserve(count);
+  for (std::size_t i = 0; i < count; i++)
+    messages.push_back(tiny(random, i).to_string());
+  return messages;
+}
+
+std::vector<std::string> sized_messages(std::size_t count,
+                                        std::size_t minBytes,
+                                        std::size_t maxBytes,
+                                        std::uint64_t seed) {
+  Random random(seed);
+  std::vector<std::string> messages;
+  messages.reserve(count);
+  for (std::size_t i = 0; i < count; i++) {
+    const std::size_t target =
+        minBytes + random.below(maxBytes - minBytes + 1);
+    messages.push_back(api_message(random, i, target));
+  }
+  return messages;
+}
+
+std::size_t count_nodes(const JObject &jobject) {
+  std::size_t count = 1;
+  if (jobject.getType() == qjson::JList) {
+    for (const auto &item : jobject.getList())
+      count += count_nodes(item);
+  } else if (jobject.getType() == qjson::JDict) {
+    for (const auto &[key, value] : jobject.getDict())
+      count += count_nodes(value);
+  }
+  return count;
+}
+
+const char *shape_name(Shape shape) {
+  switch (shape) {
+  case Shape::Deep:
+    return "deep";
+  case Shape::WideArray:
+    return "wide_array";
+  case Shape::Telemetry:
+    return "telemetry";
+  case Shape::Twitter:
+    return "twitter";
+  case Shape::Escapes:
+    return "escapes";
+  case Shape::Tiny:
+    return "tiny";
+  }
+  return "unknown";
+}
+} // namespace corpus
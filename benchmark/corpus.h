@@ -0,0 +1,96 @@
+#ifndef BENCHMARK_CORPUS_HPP
+#define BENCHMARK_CORPUS_HPP
+
+#include "../Json.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Deterministic JSON documents shaped like real traffic.
+ *
+ * The generator uses its own PRNG instead of <random> distributions, whose
+ * output differs between standard libraries, so a given (shape, size, seed)
+ * is the same document everywhere.
+ */
+namespace corpus {
+enum class Shape {
+  Deep,      ///< Chains of nested dicts and lists, 64 levels each.
+  WideArray, ///< A few long arrays of ints, doubles and mixed scalars.
+  Telemetry, ///< Records dominated by floating-point readings.
+  Twitter,   ///< Statuses with nested users, entities, UTF-8 text and nulls.
+  Escapes,   ///< Strings full of quotes, backslashes and control characters.
+  Tiny,      ///< Small request/response messages.
+};
+
+/**
+ * @brief splitmix64, small and identical on every platform.
+ */
+class Random {
+public:
+  explicit Random(std::uint64_t seed) : m_state(seed) {}
+
+  std::uint64_t next() {
+    std::uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /// Uniform in [0, bound).
+  std::uint64_t below(std::uint64_t bound) { return next() % bound; }
+
+  /// Uniform in [low, high], rounded to `decimals` digits so that the
+  /// writer's fixed six-digit output reproduces it.
+  double real(double low, double high, int decimals = 3) {
+    double scale = 1;
+    for (int i = 0; i < decimals; i++)
+      scale *= 10;
+    const auto steps = static_cast<std::uint64_t>((high - low) * scale);
+    return low + static_cast<double>(below(steps + 1)) / scale;
+  }
+
+  bool chance(unsigned percent) { return below(100) < percent; }
+
+private:
+  std::uint64_t m_state;
+};
+
+/**
+ * @brief Builds a document.
+ * @param shape The shape of the document.
+ * @param count The number of top-level items (records, chains, elements or
+ * messages); the document grows linearly with it.
+ * @param seed The PRNG seed.
+ */
+qjson::JObject generate(Shape shape, std::size_t count,
+                        std::uint64_t seed = 42);
+
+/**
+ * @brief Builds `count` tiny messages, each serialized on its own.
+ */
+std::vector<std::string> tiny_messages(std::size_t count,
+                                       std::uint64_t seed = 42);
+
+/**
+ * @brief Builds `count` API messages, each serialized on its own, with
+ * sizes spread uniformly over [minBytes, maxBytes].
+ *
+ * Each message is a request envelope around a list of small records; the
+ * list is grown until the message reaches its drawn size, so a message may
+ * overshoot it by one record.
+ */
+std::vector<std::string> sized_messages(std::size_t count,
+                                        std::size_t minBytes,
+                                        std::size_t maxBytes,
+                                        std::uint64_t seed = 42);
+
+/**
+ * @brief Counts the values in a document, containers included.
+ */
+std::size_t count_nodes(const qjson::JObject &jobject);
+
+const char *shape_name(Shape shape);
+} // namespace corpus
+
+#endif // !BENCHMARK_CORPUS_HPP
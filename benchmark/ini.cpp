@@ -0,0 +1,317 @@
+#include "../Ini.h"
+#include "alloc_counter.h"
+#include "perf_counters.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Builds `keyCount` keys, `keysPerSection` per section, using every
+// feature the dialect enables. Key i lives in section i / keysPerSection.
+// With INIBasicDialect the text is also valid for parse().
+template <class Dialect>
+std::string generate_ini(std::size_t keyCount,
+                         std::size_t keysPerSection = 16) {
+  const char *eol = Dialect::crlf ? "\r\n" : "\n";
+  std::string ini;
+  for (std::size_t i = 0; i < keyCount; ++i) {
+    if (i % keysPerSection == 0)
+      ini += "[section" + std::to_string(i / keysPerSection) + "]" + eol;
+    ini += "key" + std::to_string(i) + "=";
+    if constexpr (Dialect::quotedValues) {
+      if (i % 4 == 0) {
+        ini += "\"quoted ; value ";
+        ini += Dialect::escapeSequences ? "\\t" : "";
+        ini += std::to_string(i) + "\"";
+        ini += eol;
+        continue;
+      }
+    }
+    if constexpr (Dialect::lineContinuation) {
+      if (i % 4 == 1) {
+        ini += "first part \\";
+        ini += eol;
+        ini += "    second part";
+        ini += eol;
+        continue;
+      }
+    }
+    if constexpr (Dialect::spacesInValues)
+      ini += "value with spaces " + std::to_string(i) + " ; comment";
+    else
+      ini += "value" + std::to_string(i);
+    ini += eol;
+  }
+  return ini;
+}
+
+qini::INIObject generate_object(std::size_t keyCount) {
+  return qini::INIParser::fastParse(
+      generate_ini<qini::INIBasicDialect>(keyCount));
+}
+
+void BM_IniParse(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  std::string ini = generate_ini<qini::INIBasicDialect>(key_count);
+  qini::INIParser parser;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    auto res = parser.parse(ini);
+    benchmark::DoNotOptimize(res);
+  }
+  perf.stop();
+
+  perf.report(state, ini.size(), key_count);
+  state.SetComplexityN(key_count);
+  state.SetBytesProcessed(ini.size() * state.iterations());
+}
+BENCHMARK(BM_IniParse)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+// parallelParse() over a multi-megabyte input, by thread count; the
+// serial baseline is BM_IniParse/262144, the same input. Wall time is
+// measured, since each call starts a fresh std::thread per chunk and the
+// parsing happens on those threads.
+void BM_IniParallelParse(benchmark::State &state) {
+  const std::size_t key_count = 1 << 18;
+  const std::size_t thread_count = state.range(0);
+  std::string ini = generate_ini<qini::INIBasicDialect>(key_count);
+  qini::INIParser parser;
+  for (auto _ : state) {
+    auto res = parser.parallelParse(ini, thread_count);
+    benchmark::DoNotOptimize(res);
+  }
+
+  state.SetBytesProcessed(ini.size() * state.iterations());
+}
+BENCHMARK(BM_IniParallelParse)
+    ->ArgName("thread_count")
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Same number of keys, spread over many small or few large sections.
+void BM_IniParseRatio(benchmark::State &state) {
+  const std::size_t key_count = 1 << 16;
+  const std::size_t keys_per_section = state.range(0);
+  std::string ini =
+      generate_ini<qini::INIBasicDialect>(key_count, keys_per_section);
+  qini::INIParser parser;
+  for (auto _ : state) {
+    auto res = parser.parse(ini);
+    benchmark::DoNotOptimize(res);
+  }
+
+  state.SetBytesProcessed(ini.size() * state.iterations());
+}
+BENCHMARK(BM_IniParseRatio)
+    ->ArgName("keys_per_section")
+    ->RangeMultiplier(8)
+    ->Range(1, 1 << 15);
+
+// Rejecting malformed input, which every input here must be: entries that
+// run into the next one, or text after a header.
+void BM_IniParseMalformed(benchmark::State &state) {
+  const std::vector<std::string> inputs = {
+      "[a]\np=x[0]\nq=1\n", "[a]x=1", "[a][b]", "[a]\np=x]\n",
+      "[a]\np=x=y\n",      "[a]\np=1 q=2\n"};
+  qini::INIParser parser;
+  for (auto _ : state) {
+    for (const auto &input : inputs) {
+      try {
+        auto res = parser.parse(input);
+        benchmark::DoNotOptimize(res);
+        state.SkipWithError("malformed input accepted");
+        return;
+      } catch (const std::logic_error &) {
+      }
+    }
+  }
+
+  state.SetItemsProcessed(inputs.size() * state.iterations());
+}
+BENCHMARK(BM_IniParseMalformed);
+
+// Opening, reading and parsing a file, as done at process start.
+void BM_IniFastParseFile(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  std::string ini = generate_ini<qini::INIBasicDialect>(key_count);
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("qini_bench_" + std::to_string(key_count) + ".ini");
+  std::ofstream(path, std::ios::binary) << ini;
+  for (auto _ : state) {
+    std::ifstream infile(path, std::ios::binary);
+    auto res = qini::INIParser::fastParse(infile);
+    benchmark::DoNotOptimize(res);
+  }
+  std::filesystem::remove(path);
+
+  state.SetComplexityN(key_count);
+  state.SetBytesProcessed(ini.size() * state.iterations());
+}
+BENCHMARK(BM_IniFastParseFile)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+// One const lookup of an existing key per item, keys visited in a
+// scattered order.
+void BM_IniLookup(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  const qini::INIObject ob = generate_object(key_count);
+  std::vector<std::pair<std::string, std::string>> names;
+  names.reserve(key_count);
+  for (std::size_t i = 0; i < key_count; ++i) {
+    const std::size_t key = i * 7919 % key_count;
+    names.emplace_back("section" + std::to_string(key / 16),
+                       "key" + std::to_string(key));
+  }
+  for (auto _ : state) {
+    for (const auto &[section, key] : names)
+      benchmark::DoNotOptimize(ob[section][key]);
+  }
+
+  state.SetComplexityN(key_count);
+  state.SetItemsProcessed(names.size() * state.iterations());
+}
+BENCHMARK(BM_IniLookup)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+// Visiting every value through the section and key iterators.
+void BM_IniIterate(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  qini::INIObject ob = generate_object(key_count);
+  for (auto _ : state) {
+    for (auto section = ob.begin(); section != ob.end(); ++section) {
+      auto keys = *section;
+      for (auto value = keys.begin(); value != keys.end(); ++value)
+        benchmark::DoNotOptimize(*value);
+    }
+  }
+
+  state.SetComplexityN(key_count);
+  state.SetItemsProcessed(key_count * state.iterations());
+}
+BENCHMARK(BM_IniIterate)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+void BM_IniWrite(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  qini::INIObject ob = generate_object(key_count);
+  HeapCounter allocations;
+  for (auto _ : state) {
+    auto res = qini::INIWriter::fastWrite(ob);
+    benchmark::DoNotOptimize(res);
+  }
+
+  allocations.report(state);
+  state.SetComplexityN(key_count);
+  state.SetBytesProcessed(qini::INIWriter::fastWrite(ob).size() *
+                          state.iterations());
+}
+BENCHMARK(BM_IniWrite)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+void BM_IniWriteFile(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  qini::INIObject ob = generate_object(key_count);
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("qini_bench_out_" + std::to_string(key_count) + ".ini");
+  for (auto _ : state) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    benchmark::DoNotOptimize(qini::INIWriter::fastWrite(ob, file));
+  }
+  std::filesystem::remove(path);
+
+  state.SetComplexityN(key_count);
+  state.SetBytesProcessed(qini::INIWriter::fastWrite(ob).size() *
+                          state.iterations());
+}
+BENCHMARK(BM_IniWriteFile)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+// Dialect parsing of input written in that dialect.
+template <class Dialect> void BM_IniDialectParse(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  std::string ini = generate_ini<Dialect>(key_count);
+  qini::INIParser parser;
+  for (auto _ : state) {
+    auto res = parser.parse<Dialect>(ini);
+    benchmark::DoNotOptimize(res);
+  }
+
+  state.SetComplexityN(key_count);
+  state.SetBytesProcessed(ini.size() * state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_IniDialectParse, qini::INIBasicDialect)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+BENCHMARK_TEMPLATE(BM_IniDialectParse, qini::INIWindowsDialect)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+BENCHMARK_TEMPLATE(BM_IniDialectParse, qini::INIExtendedDialect)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+BENCHMARK_TEMPLATE(BM_IniDialectParse, qini::INIStrictDialect)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+// Dialect parsing of plain `key=value` input: the cost of the enabled
+// features when the file doesn't use them.
+template <class Dialect> void BM_IniDialectParsePlain(benchmark::State &state) {
+  const std::size_t key_count = state.range(0);
+  std::string ini = generate_ini<qini::INIBasicDialect>(key_count);
+  qini::INIParser parser;
+  for (auto _ : state) {
+    auto res = parser.parse<Dialect>(ini);
+    benchmark::DoNotOptimize(res);
+  }
+
+  state.SetComplexityN(key_count);
+  state.SetBytesProcessed(ini.size() * state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_IniDialectParsePlain, qini::INIWindowsDialect)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+BENCHMARK_TEMPLATE(BM_IniDialectParsePlain, qini::INIExtendedDialect)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 18)
+    ->Complexity();
+
+// Loads 200 sections and reads 3 of them, eagerly or lazily.
+template <bool Lazy> void BM_IniPartialRead(benchmark::State &state) {
+  std::string ini = generate_ini<qini::INIBasicDialect>(200 * 16);
+  qini::INIParser parser;
+  for (auto _ : state) {
+    const qini::INIObject res =
+        Lazy ? parser.lazyParse(ini) : parser.parse(ini);
+    for (int section : {7, 42, 199}) {
+      benchmark::DoNotOptimize(res["section" + std::to_string(section)]
+                                  ["key" + std::to_string(section * 16)]);
+    }
+  }
+
+  state.SetBytesProcessed(ini.size() * state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_IniPartialRead, false);
+BENCHMARK_TEMPLATE(BM_IniPartialRead, true);
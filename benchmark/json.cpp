@@ -0,0 +1,395 @@
+#include "../Json.h"
+#include "../JsonPatch.h"
+#include "../JsonSchemaParser.h"
+#include "../JsonShape.h"
+#include "../JsonValidator.h"
+#include "alloc_counter.h"
+#include "corpus.h"
+#include "perf_counters.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+// Parse, write and pretty-write over the corpus shapes. The argument is
+// the item count handed to corpus::generate().
+
+void BM_CorpusParse(benchmark::State &state, corpus::Shape shape) {
+  const std::size_t count = state.range(0);
+  qjson::JObject jobject = corpus::generate(shape, count);
+  std::string json = jobject.to_string();
+  const std::size_t nodes = corpus::count_nodes(jobject);
+  jobject = qjson::JObject();
+  AllocationCounter allocations;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    auto res = qjson::to_json(json);
+    benchmark::DoNotOptimize(res);
+  }
+  perf.stop();
+
+  allocations.report(state);
+  perf.report(state, json.size(), nodes);
+  state.SetComplexityN(count);
+  state.SetBytesProcessed(json.size() * state.iterations());
+}
+
+// BM_CorpusParse with a JSchemaParser compiled from a profile of another
+// document of the same shape.
+void BM_CorpusSchemaParse(benchmark::State &state, corpus::Shape shape) {
+  const std::size_t count = state.range(0);
+  qjson::JObject jobject = corpus::generate(shape, count);
+  std::string json = jobject.to_string();
+  const std::size_t nodes = corpus::count_nodes(jobject);
+  jobject = qjson::JObject();
+  qjson::JShapeProfile profile;
+  profile.addRaw(corpus::generate(shape, 16, 7).to_string());
+  qjson::JSchemaParser parser = qjson::JSchemaParser::fromShape(profile);
+  AllocationCounter allocations;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    auto res = parser.parse(json);
+    benchmark::DoNotOptimize(res);
+  }
+  perf.stop();
+
+  allocations.report(state);
+  perf.report(state, json.size(), nodes);
+  state.SetComplexityN(count);
+  state.SetBytesProcessed(json.size() * state.iterations());
+}
+
+// The writer builds a std::string on the global heap, so HeapCounter
+// rather than AllocationCounter counts its allocations.
+void BM_CorpusWrite(benchmark::State &state, corpus::Shape shape) {
+  const std::size_t count = state.range(0);
+  qjson::JObject jobject = corpus::generate(shape, count);
+  const std::size_t nodes = corpus::count_nodes(jobject);
+  std::size_t bytes = 0;
+  HeapCounter allocations;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    auto res = jobject.to_string();
+    bytes = res.size();
+    benchmark::DoNotOptimize(res);
+  }
+  perf.stop();
+
+  allocations.report(state);
+  perf.report(state, bytes, nodes);
+  state.SetComplexityN(count);
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+
+void BM_CorpusPrettyWrite(benchmark::State &state, corpus::Shape shape) {
+  const std::size_t count = state.range(0);
+  qjson::JObject jobject = corpus::generate(shape, count);
+  const std::size_t nodes = corpus::count_nodes(jobject);
+  std::size_t bytes = 0;
+  HeapCounter allocations;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    auto res = jobject.to_string(4);
+    bytes = res.size();
+    benchmark::DoNotOptimize(res);
+  }
+  perf.stop();
+
+  allocations.report(state);
+  perf.report(state, bytes, nodes);
+  state.SetComplexityN(count);
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+
+// What the parsed document occupies, from memory_usage() and, as a check,
+// from the bytes the parse left allocated. The loop times memory_usage().
+void BM_CorpusFootprint(benchmark::State &state, corpus::Shape shape) {
+  const std::size_t count = state.range(0);
+  const std::string json = corpus::generate(shape, count).to_string();
+  // The document keeps pointing at the counting resource, so it must be
+  // destroyed first.
+  AllocationCounter allocations;
+  const qjson::JObject document = qjson::to_json(json);
+  const std::size_t measured = allocations.resource().live();
+  qjson::JMemoryUsage usage;
+  for (auto _ : state) {
+    usage = qjson::memory_usage(document);
+    benchmark::DoNotOptimize(usage);
+  }
+
+  const double input = static_cast<double>(json.size());
+  state.counters["ram/input_byte"] = usage.total() / input;
+  state.counters["ram/node"] =
+      static_cast<double>(usage.total()) / usage.count;
+  state.counters["nodes/input_byte"] = usage.nodes / input;
+  state.counters["strings/input_byte"] = usage.strings / input;
+  state.counters["buckets/input_byte"] = usage.buckets / input;
+  state.counters["slack/input_byte"] = usage.slack / input;
+  state.counters["measured/input_byte"] =
+      (measured + sizeof(qjson::JObject)) / input;
+  state.SetComplexityN(count);
+  state.SetItemsProcessed(usage.count * state.iterations());
+}
+
+// Validation of a parsed telemetry document against a schema of its
+// records: types, ranges, an enum and a pattern per record.
+void BM_TelemetryValidate(benchmark::State &state) {
+  const std::size_t count = state.range(0);
+  const qjson::JObject document =
+      corpus::generate(corpus::Shape::Telemetry, count);
+  const qjson::JValidator validator =
+      qjson::JValidator::compile(qjson::to_json(R"({
+        "type": "object",
+        "required": ["source", "records"],
+        "properties": {
+          "source": {"type": "string"},
+          "records": {"type": "array", "items": {"$ref": "#/$defs/record"}}
+        },
+        "$defs": {
+          "record": {
+            "type": "object",
+            "required": ["ts", "host", "metric", "value", "cpu", "samples",
+                         "tags"],
+            "additionalProperties": false,
+            "properties": {
+              "ts": {"type": "integer", "minimum": 0},
+              "host": {"type": "string", "pattern": "^node-[0-9]+$"},
+              "metric": {"enum": ["cpu.load", "mem.used", "disk.io",
+                                  "net.rx", "net.tx", "temp"]},
+              "value": {"type": "number", "minimum": 0},
+              "cpu": {
+                "type": "object",
+                "additionalProperties": {"type": "number", "minimum": 0}
+              },
+              "samples": {"type": "array", "items": {"type": "number"},
+                          "maxItems": 16},
+              "tags": {
+                "type": "object",
+                "required": ["region"],
+                "properties": {
+                  "region": {"type": "string", "minLength": 1},
+                  "rack": {"type": "integer", "maximum": 63}
+                }
+              }
+            }
+          }
+        }
+      })"));
+  if (!validator.validate(document))
+    state.SkipWithError("the corpus does not match its schema");
+  for (auto _ : state) {
+    bool valid = validator.validate(document);
+    benchmark::DoNotOptimize(valid);
+  }
+
+  state.SetComplexityN(count);
+  state.SetItemsProcessed(count * state.iterations());
+}
+BENCHMARK(BM_TelemetryValidate)
+    ->RangeMultiplier(4)
+    ->Range(1 << 5, 1 << 15)
+    ->Complexity();
+
+// A telemetry document with the value of every 64th record changed, as a
+// periodic update would leave it.
+namespace {
+qjson::JObject edit_telemetry(const qjson::JObject &document) {
+  qjson::JObject edited = document;
+  auto &records = edited["records"].getList();
+  for (std::size_t i = 0; i < records.size(); i += 64)
+    records[i]["value"] = qjson::JObject(-1.0);
+  return edited;
+}
+} // namespace
+
+void BM_TelemetryDiff(benchmark::State &state) {
+  const std::size_t count = state.range(0);
+  const qjson::JObject document =
+      corpus::generate(corpus::Shape::Telemetry, count);
+  const qjson::JObject edited = edit_telemetry(document);
+  for (auto _ : state) {
+    qjson::JObject patch = qjson::diff(document, edited);
+    benchmark::DoNotOptimize(patch);
+  }
+
+  state.SetComplexityN(count);
+  state.SetItemsProcessed(count * state.iterations());
+}
+BENCHMARK(BM_TelemetryDiff)
+    ->RangeMultiplier(4)
+    ->Range(1 << 5, 1 << 15)
+    ->Complexity();
+
+// Applies the edit and its inverse in place, so the document is the same
+// at the start of every iteration.
+void BM_TelemetryPatch(benchmark::State &state) {
+  const std::size_t count = state.range(0);
+  qjson::JObject document = corpus::generate(corpus::Shape::Telemetry, count);
+  const qjson::JObject edited = edit_telemetry(document);
+  const qjson::JObject forward = qjson::diff(document, edited);
+  const qjson::JObject backward = qjson::diff(edited, document);
+  for (auto _ : state) {
+    qjson::apply_patch(document, forward);
+    qjson::apply_patch(document, backward);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetComplexityN(count);
+  state.SetItemsProcessed(forward.getList().size() * state.iterations());
+}
+BENCHMARK(BM_TelemetryPatch)
+    ->RangeMultiplier(4)
+    ->Range(1 << 5, 1 << 15)
+    ->Complexity();
+
+#define CORPUS_BENCHMARK(func, name, shape, low, high)                        \
+  BENCHMARK_CAPTURE(func, name, corpus::Shape::shape)                         \
+      ->RangeMultiplier(4)                                                    \
+      ->Range(low, high)                                                      \
+      ->Complexity()
+
+#define CORPUS_BENCHMARKS(name, shape, low, high)                             \
+  CORPUS_BENCHMARK(BM_CorpusParse, name, shape, low, high);                   \
+  CORPUS_BENCHMARK(BM_CorpusSchemaParse, name, shape, low, high);             \
+  CORPUS_BENCHMARK(BM_CorpusWrite, name, shape, low, high);                   \
+  CORPUS_BENCHMARK(BM_CorpusPrettyWrite, name, shape, low, high);            \
+  CORPUS_BENCHMARK(BM_CorpusFootprint, name, shape, low, high)
+
+// Item counts are scaled so each shape spans roughly 10 KB to 10 MB.
+CORPUS_BENCHMARKS(deep, Deep, 1 << 3, 1 << 13);
+CORPUS_BENCHMARKS(wide_array, WideArray, 1 << 8, 1 << 18);
+CORPUS_BENCHMARKS(telemetry, Telemetry, 1 << 5, 1 << 15);
+CORPUS_BENCHMARKS(twitter, Twitter, 1 << 4, 1 << 14);
+CORPUS_BENCHMARKS(escapes, Escapes, 1 << 6, 1 << 16);
+
+// Tiny messages are parsed and written one at a time, as a server would.
+void BM_TinyParse(benchmark::State &state) {
+  std::vector<std::string> messages = corpus::tiny_messages(1024);
+  std::size_t bytes = 0;
+  for (const auto &message : messages)
+    bytes += message.size();
+  const std::size_t nodes =
+      corpus::count_nodes(corpus::generate(corpus::Shape::Tiny, 1024)) - 1;
+  AllocationCounter allocations;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    for (const auto &message : messages) {
+      auto res = qjson::to_json(message);
+      benchmark::DoNotOptimize(res);
+    }
+  }
+  perf.stop();
+
+  allocations.report(state);
+  perf.report(state, bytes, nodes);
+  state.SetItemsProcessed(messages.size() * state.iterations());
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+BENCHMARK(BM_TinyParse);
+
+void BM_TinySchemaParse(benchmark::State &state) {
+  std::vector<std::string> messages = corpus::tiny_messages(1024);
+  std::size_t bytes = 0;
+  qjson::JShapeProfile profile;
+  for (const auto &message : messages) {
+    bytes += message.size();
+    profile.addRaw(message);
+  }
+  qjson::JSchemaParser parser = qjson::JSchemaParser::fromShape(profile);
+  AllocationCounter allocations;
+  for (auto _ : state) {
+    for (const auto &message : messages) {
+      auto res = parser.parse(message);
+      benchmark::DoNotOptimize(res);
+    }
+  }
+
+  allocations.report(state);
+  state.SetItemsProcessed(messages.size() * state.iterations());
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+BENCHMARK(BM_TinySchemaParse);
+
+void BM_TinyWrite(benchmark::State &state) {
+  qjson::JObject messages = corpus::generate(corpus::Shape::Tiny, 1024);
+  const auto &list = messages.getList();
+  const std::size_t nodes = corpus::count_nodes(messages) - 1;
+  std::size_t bytes = 0;
+  HeapCounter allocations;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    bytes = 0;
+    for (const auto &message : list) {
+      auto res = message.to_string();
+      bytes += res.size();
+      benchmark::DoNotOptimize(res);
+    }
+  }
+  perf.stop();
+
+  allocations.report(state);
+  perf.report(state, bytes, nodes);
+  state.SetItemsProcessed(list.size() * state.iterations());
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+BENCHMARK(BM_TinyWrite);
+
+void BM_TinyPrettyWrite(benchmark::State &state) {
+  qjson::JObject messages = corpus::generate(corpus::Shape::Tiny, 1024);
+  const auto &list = messages.getList();
+  const std::size_t nodes = corpus::count_nodes(messages) - 1;
+  std::size_t bytes = 0;
+  HeapCounter allocations;
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    bytes = 0;
+    for (const auto &message : list) {
+      auto res = message.to_string(4);
+      bytes += res.size();
+      benchmark::DoNotOptimize(res);
+    }
+  }
+  perf.stop();
+
+  allocations.report(state);
+  perf.report(state, bytes, nodes);
+  state.SetItemsProcessed(list.size() * state.iterations());
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+BENCHMARK(BM_TinyPrettyWrite);
+
+// Profiling the shape of small messages, from their text and from the
+// parsed tree. Against BM_TinyParse, this is what sampling costs.
+void BM_ShapeProfile(benchmark::State &state, bool raw) {
+  const std::vector<std::string> messages = corpus::tiny_messages(1024);
+  std::vector<qjson::JObject> documents;
+  std::size_t bytes = 0;
+  for (const auto &message : messages) {
+    bytes += message.size();
+    if (!raw)
+      documents.push_back(qjson::to_json(message));
+  }
+  qjson::JShapeProfile profile;
+  for (auto _ : state) {
+    if (raw) {
+      for (const auto &message : messages)
+        profile.addRaw(message);
+    } else {
+      for (const auto &document : documents)
+        profile.add(document);
+    }
+    benchmark::DoNotOptimize(profile);
+  }
+
+  state.SetItemsProcessed(messages.size() * state.iterations());
+  if (raw)
+    state.SetBytesProcessed(bytes * state.iterations());
+}
+BENCHMARK_CAPTURE(BM_ShapeProfile, raw, true);
+BENCHMARK_CAPTURE(BM_ShapeProfile, parsed, false);
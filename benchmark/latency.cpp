@@ -0,0 +1,247 @@
+// Per-operation latency of small-message parse and write.
+//
+// Google Benchmark reports means over many iterations, which hides the
+// occasional slow operation (an allocator refill, a rehash, a cache miss).
+// This harness times every operation on its own and reports percentiles.
+//
+//   bench_latency [--messages=N] [--ops=N] [--cold_ops=N] [--warm_set=N]
+//                 [--min_bytes=N] [--max_bytes=N] [--evict_bytes=N]
+//                 [--format=text|json]
+//
+// warm: a small set of messages is cycled after a warm-up, so data, code
+//       and allocator free lists stay hot.
+// cold: before every operation a buffer larger than the last-level cache
+//       is read, and every message is visited once per pass.
+#include "../Json.h"
+#include "corpus.h"
+#include "latency_histogram.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+struct Options {
+  std::size_t messages = 4096;
+  std::size_t ops = 200000;
+  std::size_t coldOps = 2000;
+  std::size_t warmSet = 64;
+  std::size_t minBytes = 200;
+  std::size_t maxBytes = 4096;
+  std::size_t evictBytes = 0; ///< 0: twice the largest cache.
+  bool json = false;
+};
+
+struct Result {
+  const char *operation;
+  const char *cache;
+  LatencyHistogram histogram;
+};
+
+constexpr double percentiles[] = {50, 90, 99, 99.9, 99.99};
+constexpr const char *percentile_names[] = {"p50", "p90", "p99", "p99.9",
+                                            "p99.99"};
+
+void usage() {
+  std::fputs("usage: bench_latency [--messages=N] [--ops=N] [--cold_ops=N]"
+             " [--warm_set=N]\n"
+             "                     [--min_bytes=N] [--max_bytes=N]"
+             " [--evict_bytes=N]\n"
+             "                     [--format=text|json]\n",
+             stderr);
+}
+
+bool parse_size(std::string_view arg, std::string_view name,
+                std::size_t &value) {
+  if (!arg.starts_with(name) || arg.size() == name.size() ||
+      arg[name.size()] != '=')
+    return false;
+  const std::string digits(arg.substr(name.size() + 1));
+  char *end = nullptr;
+  const unsigned long long parsed = std::strtoull(digits.c_str(), &end, 10);
+  if (digits.empty() || *end != '\0') {
+    std::fprintf(stderr, "bench_latency: bad value in %.*s\n",
+                 static_cast<int>(arg.size()), arg.data());
+    std::exit(1);
+  }
+  value = static_cast<std::size_t>(parsed);
+  return true;
+}
+
+Options parse_options(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg = argv[i];
+    if (parse_size(arg, "--messages", options.messages) ||
+        parse_size(arg, "--ops", options.ops) ||
+        parse_size(arg, "--cold_ops", options.coldOps) ||
+        parse_size(arg, "--warm_set", options.warmSet) ||
+        parse_size(arg, "--min_bytes", options.minBytes) ||
+        parse_size(arg, "--max_bytes", options.maxBytes) ||
+        parse_size(arg, "--evict_bytes", options.evictBytes))
+      continue;
+    if (arg == "--format=json" || arg == "--format=text") {
+      options.json = arg == "--format=json";
+      continue;
+    }
+    usage();
+    std::exit(arg == "--help" ? 0 : 1);
+  }
+  if (options.messages == 0 || options.minBytes > options.maxBytes) {
+    usage();
+    std::exit(1);
+  }
+  options.warmSet = std::clamp<std::size_t>(options.warmSet, 1,
+                                            options.messages);
+  if (options.evictBytes == 0) {
+    std::size_t largest = 0;
+    for (const auto &cache : benchmark::CPUInfo::Get().caches)
+      largest = std::max<std::size_t>(largest, cache.size);
+    options.evictBytes = largest == 0 ? (64u << 20) : 2 * largest;
+  }
+  return options;
+}
+
+/**
+ * @brief Reads a buffer larger than the caches, pushing everything else out.
+ */
+class CacheEvictor {
+public:
+  explicit CacheEvictor(std::size_t bytes) : m_buffer(bytes / 8 + 1, 1) {}
+
+  void evict() {
+    std::uint64_t sum = 0;
+    // One load per 64-byte line is enough to claim it.
+    for (std::size_t i = 0; i < m_buffer.size(); i += 8)
+      sum += m_buffer[i];
+    benchmark::DoNotOptimize(sum);
+  }
+
+private:
+  std::vector<std::uint64_t> m_buffer;
+};
+
+template <class Operation>
+void time_one(LatencyHistogram &histogram, Operation &&operation) {
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  operation();
+  const auto stop = clock::now();
+  histogram.record(static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+          .count()));
+}
+
+template <class Operation>
+LatencyHistogram run_warm(const Options &options, Operation &&operation) {
+  LatencyHistogram histogram;
+  for (std::size_t i = 0; i < std::min<std::size_t>(options.ops, 10000); i++)
+    operation(i % options.warmSet);
+  for (std::size_t i = 0; i < options.ops; i++)
+    time_one(histogram, [&] { operation(i % options.warmSet); });
+  return histogram;
+}
+
+template <class Operation>
+LatencyHistogram run_cold(const Options &options, CacheEvictor &evictor,
+                          Operation &&operation) {
+  LatencyHistogram histogram;
+  for (std::size_t i = 0; i < options.coldOps; i++) {
+    evictor.evict();
+    time_one(histogram, [&] { operation(i % options.messages); });
+  }
+  return histogram;
+}
+
+void print_text(const Options &options, const std::vector<Result> &results,
+                std::size_t totalBytes) {
+  std::printf("%zu messages, %zu-%zu bytes (mean %zu), evicting %zu KiB "
+              "for cold runs\n",
+              options.messages, options.minBytes, options.maxBytes,
+              totalBytes / options.messages, options.evictBytes >> 10);
+  std::printf("%-8s %-5s %9s %9s", "op", "cache", "count", "mean");
+  for (const char *name : percentile_names)
+    std::printf(" %9s", name);
+  std::printf(" %9s   (ns)\n", "max");
+  for (const auto &result : results) {
+    const auto &histogram = result.histogram;
+    std::printf("%-8s %-5s %9llu %9.0f", result.operation, result.cache,
+                static_cast<unsigned long long>(histogram.count()),
+                histogram.mean());
+    for (double percent : percentiles)
+      std::printf(" %9llu", static_cast<unsigned long long>(
+                                histogram.percentile(percent)));
+    std::printf(" %9llu\n",
+                static_cast<unsigned long long>(histogram.max()));
+  }
+}
+
+void print_json(const Options &options, const std::vector<Result> &results,
+                std::size_t totalBytes) {
+  qjson::JObject report(qjson::JDict);
+  report["messages"] = static_cast<qjson::int_t>(options.messages);
+  report["mean_message_bytes"] =
+      static_cast<qjson::int_t>(totalBytes / options.messages);
+  report["evict_bytes"] = static_cast<qjson::int_t>(options.evictBytes);
+  qjson::JObject list(qjson::JList);
+  for (const auto &result : results) {
+    const auto &histogram = result.histogram;
+    qjson::JObject entry(qjson::JDict);
+    entry["operation"] = std::string_view(result.operation);
+    entry["cache"] = std::string_view(result.cache);
+    entry["count"] = static_cast<qjson::int_t>(histogram.count());
+    entry["mean_ns"] = histogram.mean();
+    entry["min_ns"] = static_cast<qjson::int_t>(histogram.min());
+    for (std::size_t i = 0; i < std::size(percentiles); i++)
+      entry[std::string(percentile_names[i]) + "_ns"] =
+          static_cast<qjson::int_t>(histogram.percentile(percentiles[i]));
+    entry["max_ns"] = static_cast<qjson::int_t>(histogram.max());
+    list.push_back(std::move(entry));
+  }
+  report["results"] = std::move(list);
+  std::puts(report.to_string(2).c_str());
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const Options options = parse_options(argc, argv);
+
+  const std::vector<std::string> messages = corpus::sized_messages(
+      options.messages, options.minBytes, options.maxBytes);
+  std::size_t totalBytes = 0;
+  std::vector<qjson::JObject> documents;
+  documents.reserve(messages.size());
+  for (const auto &message : messages) {
+    totalBytes += message.size();
+    documents.push_back(qjson::to_json(message));
+  }
+
+  CacheEvictor evictor(options.evictBytes);
+  qjson::JWriter writer;
+  const auto parse = [&](std::size_t i) {
+    auto res = qjson::to_json(messages[i]);
+    benchmark::DoNotOptimize(res);
+  };
+  const auto write = [&](std::size_t i) {
+    auto res = writer.write(documents[i]);
+    benchmark::DoNotOptimize(res);
+  };
+
+  std::vector<Result> results;
+  results.push_back({"parse", "warm", run_warm(options, parse)});
+  results.push_back({"parse", "cold", run_cold(options, evictor, parse)});
+  results.push_back({"write", "warm", run_warm(options, write)});
+  results.push_back({"write", "cold", run_cold(options, evictor, write)});
+
+  if (options.json)
+    print_json(options, results, totalBytes);
+  else
+    print_text(options, results, totalBytes);
+  return 0;
+}
@@ -0,0 +1,115 @@
+#ifndef BENCHMARK_LATENCY_HISTOGRAM_HPP
+#define BENCHMARK_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Log-linear histogram of latencies, in the style of HdrHistogram.
+ *
+ * Values below 2^SubBits are counted exactly; above that, every power of two
+ * is split into 2^(SubBits-1) equal buckets, so a recorded value is known to
+ * within 2^-(SubBits-1) of itself (0.8% with the default 8 bits) whatever its
+ * magnitude. Recording is a few shifts and an increment, and the whole
+ * 64-bit range fits in a fixed array, so the histogram never allocates
+ * while measuring.
+ */
+template <unsigned SubBits = 8> class BasicLatencyHistogram {
+  static_assert(SubBits >= 2 && SubBits < 32);
+
+  static constexpr std::uint64_t subCount = std::uint64_t{1} << SubBits;
+  static constexpr std::uint64_t halfCount = subCount / 2;
+  static constexpr std::size_t bucketCount =
+      subCount + (64 - SubBits) * halfCount;
+
+public:
+  BasicLatencyHistogram() : m_counts(bucketCount, 0) {}
+
+  void record(std::uint64_t value) noexcept {
+    m_counts[index_(value)]++;
+    m_count++;
+    m_sum += value;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  void merge(const BasicLatencyHistogram &other) noexcept {
+    for (std::size_t i = 0; i < bucketCount; i++)
+      m_counts[i] += other.m_counts[i];
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  void reset() noexcept {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_sum = 0;
+    m_min = std::numeric_limits<std::uint64_t>::max();
+    m_max = 0;
+  }
+
+  std::uint64_t count() const noexcept { return m_count; }
+  std::uint64_t min() const noexcept { return m_count == 0 ? 0 : m_min; }
+  std::uint64_t max() const noexcept { return m_max; }
+  double mean() const noexcept {
+    return m_count == 0 ? 0 : static_cast<double>(m_sum) / m_count;
+  }
+
+  /**
+   * @brief The smallest value that at least `percent`% of the recorded
+   * values are less than or equal to.
+   *
+   * The answer is the upper edge of the bucket holding that value, clamped
+   * to the exact maximum, so p100 is the true maximum.
+   */
+  std::uint64_t percentile(double percent) const noexcept {
+    if (m_count == 0)
+      return 0;
+    const double clamped = std::clamp(percent, 0.0, 100.0);
+    auto rank =
+        static_cast<std::uint64_t>(clamped / 100 * m_count + 0.5);
+    rank = std::clamp<std::uint64_t>(rank, 1, m_count);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; i++) {
+      seen += m_counts[i];
+      if (seen >= rank)
+        return std::min(highestEquivalent_(i), m_max);
+    }
+    return m_max;
+  }
+
+private:
+  static std::size_t index_(std::uint64_t value) noexcept {
+    if (value < subCount)
+      return static_cast<std::size_t>(value);
+    const unsigned shift = std::bit_width(value) - SubBits;
+    const std::uint64_t mantissa = value >> shift;
+    return static_cast<std::size_t>(subCount + (shift - 1) * halfCount +
+                                    (mantissa - halfCount));
+  }
+
+  static std::uint64_t highestEquivalent_(std::size_t index) noexcept {
+    if (index < subCount)
+      return index;
+    const std::uint64_t offset = index - subCount;
+    const std::uint64_t shift = offset / halfCount + 1;
+    const std::uint64_t mantissa = offset % halfCount + halfCount;
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+  std::vector<std::uint64_t> m_counts;
+  std::uint64_t m_count = 0;
+  std::uint64_t m_sum = 0;
+  std::uint64_t m_min = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t m_max = 0;
+};
+
+using LatencyHistogram = BasicLatencyHistogram<>;
+
+#endif // !BENCHMARK_LATENCY_HISTOGRAM_HPP
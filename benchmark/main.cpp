@@ -1,8 +1,12 @@
 #include "../Json.h"
+#include "alloc_counter.h"
+#include "perf_counters.h"
 #include <benchmark/benchmark.h>
 #include <cstdint>
-#include <nlohmann/json.hpp>
 #include <random>
+#ifdef FILEPARSER_HAS_NLOHMANN
+#include <nlohmann/json.hpp>
+#endif
 
 long long generate_num() {
   static std::random_device rd;
@@ -18,11 +22,17 @@ void BM_MyJsonParse(benchmark::State &state) {
     jobject[std::to_string(i)] = std::to_string(generate_num());
   }
   std::string json = jobject.to_string();
+  AllocationCounter allocations;
+  PerfCounters perf;
+  perf.start();
   for (auto _ : state) {
     auto res = qjson::to_json(json);
     benchmark::DoNotOptimize(res);
   }
+  perf.stop();
 
+  allocations.report(state);
+  perf.report(state, json.size(), array_size + 1);
   state.SetComplexityN(array_size);
   state.SetBytesProcessed(json.size() * state.iterations());
 }
@@ -31,25 +41,35 @@ BENCHMARK(BM_MyJsonParse)
     ->Range(1 << 10, 1 << 20)
     ->Complexity();
 
+// The written std::string is not a pmr allocation, so HeapCounter counts
+// the writes.
 void BM_MyJsonWrite(benchmark::State &state) {
   const size_t array_size = state.range(0);
   qjson::JObject jobject;
   for (size_t i = 0; i < array_size; ++i) {
     jobject[std::to_string(i)] = std::to_string(generate_num());
   }
+  const std::size_t bytes = jobject.to_string().size();
+  HeapCounter allocations;
+  PerfCounters perf;
+  perf.start();
   for (auto _ : state) {
     auto res = jobject.to_string();
     benchmark::DoNotOptimize(res);
   }
+  perf.stop();
 
+  allocations.report(state);
+  perf.report(state, bytes, array_size + 1);
   state.SetComplexityN(array_size);
-  state.SetBytesProcessed(jobject.to_string().size() * state.iterations());
+  state.SetBytesProcessed(bytes * state.iterations());
 }
 BENCHMARK(BM_MyJsonWrite)
     ->RangeMultiplier(2)
     ->Range(1 << 10, 1 << 20)
     ->Complexity();
 
+#ifdef FILEPARSER_HAS_NLOHMANN
 void BM_NlohmannJsonParse(benchmark::State &state) {
   const size_t array_size = state.range(0);
   qjson::JObject jobject;
@@ -76,11 +96,13 @@ void BM_NlohmannJsonWrite(benchmark::State &state) {
   for (size_t i = 0; i < array_size; ++i) {
     jobject[std::to_string(i)] = std::to_string(generate_num());
   }
+  HeapCounter allocations;
   for (auto _ : state) {
     auto res = jobject.dump();
     benchmark::DoNotOptimize(res);
   }
 
+  allocations.report(state);
   state.SetComplexityN(array_size);
   state.SetBytesProcessed(jobject.dump().size() * state.iterations());
 }
@@ -88,5 +110,6 @@ BENCHMARK(BM_NlohmannJsonWrite)
     ->RangeMultiplier(2)
     ->Range(1 << 10, 1 << 20)
     ->Complexity();
+#endif // FILEPARSER_HAS_NLOHMANN
 
 BENCHMARK_MAIN();
@@ -0,0 +1,23 @@
+#ifndef BENCHMARK_PARSER_HOOK_HPP
+#define BENCHMARK_PARSER_HOOK_HPP
+
+#include "../Json.h"
+
+/**
+ * @brief Makes JParser's protected tokenizer primitives callable, so each
+ * can be measured on its own.
+ *
+ * The primitives keep their contract: `iter` must point at the first
+ * character of the token, and is left just past it.
+ */
+class JParserHook : public qjson::JParser {
+public:
+  using JParser::getBool;
+  using JParser::getNull;
+  using JParser::getNumber;
+  using JParser::getString;
+  using JParser::parse_;
+  using JParser::skipSpace;
+};
+
+#endif // !BENCHMARK_PARSER_HOOK_HPP
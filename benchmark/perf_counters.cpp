@@ -0,0 +1,140 @@
+#include "perf_counters.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+bool enabled() {
+  const char *value = std::getenv("FILEPARSER_PERF_COUNTERS");
+  return value != nullptr && *value != '\0' && std::strcmp(value, "0") != 0;
+}
+
+#ifdef __linux__
+struct EventSpec {
+  const char *name;
+  std::uint32_t type;
+  std::uint64_t config;
+};
+
+constexpr std::uint64_t cache_read_miss(std::uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr EventSpec event_specs[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"L1d-misses", PERF_TYPE_HW_CACHE,
+     cache_read_miss(PERF_COUNT_HW_CACHE_L1D)},
+    {"LLC-misses", PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_LL)},
+    {"dTLB-misses", PERF_TYPE_HW_CACHE,
+     cache_read_miss(PERF_COUNT_HW_CACHE_DTLB)},
+};
+
+int open_event(const EventSpec &spec) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = spec.type;
+  attr.config = spec.config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Each event leads its own group, so one the PMU can't schedule alongside
+  // the others is multiplexed instead of zeroing the whole set.
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+} // namespace
+
+PerfCounters::PerfCounters() {
+  if (!enabled())
+    return;
+#ifdef __linux__
+  for (const auto &spec : event_specs) {
+    const int fd = open_event(spec);
+    if (fd >= 0)
+      m_events.push_back({spec.name, fd});
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (const auto &event : m_events)
+    close(event.fd);
+#endif
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+  for (const auto &event : m_events) {
+    ioctl(event.fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(event.fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+
+void PerfCounters::stop() {
+#ifdef __linux__
+  for (const auto &event : m_events)
+    ioctl(event.fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+double PerfCounters::read_(const Event &event) const {
+#ifdef __linux__
+  struct {
+    std::uint64_t value;
+    std::uint64_t timeEnabled;
+    std::uint64_t timeRunning;
+  } data{};
+  if (::read(event.fd, &data, sizeof(data)) != sizeof(data) ||
+      data.timeRunning == 0)
+    return -1;
+  return static_cast<double>(data.value) *
+         static_cast<double>(data.timeEnabled) /
+         static_cast<double>(data.timeRunning);
+#else
+  (void)event;
+  return -1;
+#endif
+}
+
+void PerfCounters::report(benchmark::State &state, double bytes,
+                          double nodes) const {
+  const double iterations = static_cast<double>(state.iterations());
+  if (!active() || iterations == 0)
+    return;
+
+  double cycles = -1;
+  double instructions = -1;
+  for (const auto &event : m_events) {
+    const double count = read_(event);
+    if (count < 0)
+      continue;
+    const double perIteration = count / iterations;
+    const std::string name = event.name;
+    if (bytes > 0)
+      state.counters[name + "/byte"] = perIteration / bytes;
+    if (nodes > 0)
+      state.counters[name + "/node"] = perIteration / nodes;
+    if (name == "cycles")
+      cycles = count;
+    else if (name == "instructions")
+      instructions = count;
+  }
+  if (cycles > 0 && instructions >= 0)
+    state.counters["IPC"] = instructions / cycles;
+}
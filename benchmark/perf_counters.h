@@ -0,0 +1,52 @@
+#ifndef BENCHMARK_PERF_COUNTERS_HPP
+#define BENCHMARK_PERF_COUNTERS_HPP
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Hardware counters read through Linux perf_event_open.
+ *
+ * Collection is off unless the FILEPARSER_PERF_COUNTERS environment
+ * variable is set to something other than "0". Events the CPU, kernel or
+ * sandbox refuse (see /proc/sys/kernel/perf_event_paranoid) are skipped
+ * silently; on other systems, or if none can be opened, the object does
+ * nothing. Only user-space events of the calling thread are counted, and
+ * multiplexed counts are scaled by their enabled/running time.
+ */
+class PerfCounters {
+public:
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  /// true if at least one event is being counted.
+  bool active() const noexcept { return !m_events.empty(); }
+
+  void start();
+  void stop();
+
+  /**
+   * @brief Adds `<event>/byte` and `<event>/node` counters, plus IPC.
+   * @param state The benchmark state; its iteration count is used.
+   * @param bytes Bytes handled per iteration.
+   * @param nodes Values (JSON nodes, INI keys) handled per iteration.
+   */
+  void report(benchmark::State &state, double bytes, double nodes) const;
+
+private:
+  struct Event {
+    const char *name;
+    int fd;
+  };
+
+  /// Scaled count since start(), or -1 if the event never ran.
+  double read_(const Event &event) const;
+
+  std::vector<Event> m_events;
+};
+
+#endif // !BENCHMARK_PERF_COUNTERS_HPP
@@ -0,0 +1,158 @@
+#include "../Json.h"
+#include "corpus.h"
+#include "parser_hook.h"
+#include <benchmark/benchmark.h>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// The parser's building blocks in isolation. Each benchmark runs one
+// primitive over a buffer of `range(0)` tokens (or characters), so a change
+// to a single kernel shows up without the noise of a whole document.
+
+namespace {
+// Tokens separated by commas, the way they appear inside a list.
+template <class Token>
+std::string token_list(std::size_t count, Token &&token) {
+  corpus::Random random(42);
+  std::string data;
+  for (std::size_t i = 0; i < count; i++) {
+    if (i != 0)
+      data += ',';
+    data += token(random);
+  }
+  return data;
+}
+
+// Calls `primitive` on every comma-separated token of `data`.
+template <class Primitive>
+void run_tokens(benchmark::State &state, const std::string &data,
+                std::size_t count, Primitive &&primitive) {
+  const std::size_t size = data.size();
+  for (auto _ : state) {
+    std::size_t iter = 0;
+    while (iter < size) {
+      auto res = primitive(data, size, iter);
+      benchmark::DoNotOptimize(res);
+      ++iter;
+    }
+  }
+  state.SetComplexityN(count);
+  state.SetItemsProcessed(count * state.iterations());
+  state.SetBytesProcessed(size * state.iterations());
+}
+} // namespace
+
+void BM_SkipSpace(benchmark::State &state) {
+  const std::size_t length = state.range(0);
+  std::string data;
+  for (std::size_t i = 0; i < length; i++)
+    data += " \t \n"[i % 4];
+  data += 'x';
+  for (auto _ : state) {
+    std::size_t iter = 0;
+    long long error_line = 0;
+    JParserHook::skipSpace(data, data.size(), iter, error_line);
+    benchmark::DoNotOptimize(iter);
+  }
+  state.SetComplexityN(length);
+  state.SetBytesProcessed(length * state.iterations());
+}
+BENCHMARK(BM_SkipSpace)->RangeMultiplier(8)->Range(8, 1 << 15)->Complexity();
+
+void BM_GetString(benchmark::State &state, bool escapes) {
+  constexpr const char *sequences[] = {"\\n", "\\\"", "\\\\", "\\t"};
+  const std::size_t length = state.range(0);
+  corpus::Random random(42);
+  std::string data = "\"";
+  while (data.size() <= length) {
+    if (escapes && random.chance(10))
+      data += sequences[random.below(std::size(sequences))];
+    else
+      data += static_cast<char>('a' + random.below(26));
+  }
+  data += '"';
+  for (auto _ : state) {
+    std::size_t iter = 0;
+    auto res = JParserHook::getString(data, data.size(), iter, 0);
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetComplexityN(length);
+  state.SetBytesProcessed(data.size() * state.iterations());
+}
+BENCHMARK_CAPTURE(BM_GetString, plain, false)
+    ->RangeMultiplier(8)
+    ->Range(8, 1 << 15)
+    ->Complexity();
+BENCHMARK_CAPTURE(BM_GetString, escapes, true)
+    ->RangeMultiplier(8)
+    ->Range(8, 1 << 15)
+    ->Complexity();
+
+void BM_GetNumber(benchmark::State &state, bool doubles) {
+  const std::size_t count = state.range(0);
+  const std::string data =
+      token_list(count, [doubles](corpus::Random &random) {
+        std::string number = random.chance(20) ? "-" : "";
+        number += std::to_string(random.below(1000000));
+        if (doubles) {
+          number += '.';
+          number += std::to_string(random.below(10000));
+        }
+        return number;
+      });
+  run_tokens(state, data, count,
+             [](std::string_view text, std::size_t size, std::size_t &iter) {
+               return JParserHook::getNumber(text, size, iter, 0);
+             });
+}
+BENCHMARK_CAPTURE(BM_GetNumber, int, false)
+    ->RangeMultiplier(8)
+    ->Range(8, 1 << 15)
+    ->Complexity();
+BENCHMARK_CAPTURE(BM_GetNumber, double, true)
+    ->RangeMultiplier(8)
+    ->Range(8, 1 << 15)
+    ->Complexity();
+
+void BM_GetBool(benchmark::State &state) {
+  const std::size_t count = state.range(0);
+  const std::string data = token_list(count, [](corpus::Random &random) {
+    return std::string(random.chance(50) ? "true" : "false");
+  });
+  run_tokens(state, data, count,
+             [](std::string_view text, std::size_t size, std::size_t &iter) {
+               return JParserHook::getBool(text, size, iter, 0);
+             });
+}
+BENCHMARK(BM_GetBool)->RangeMultiplier(8)->Range(8, 1 << 15)->Complexity();
+
+void BM_GetNull(benchmark::State &state) {
+  const std::size_t count = state.range(0);
+  const std::string data = token_list(
+      count, [](corpus::Random &) { return std::string("null"); });
+  run_tokens(state, data, count,
+             [](std::string_view text, std::size_t size, std::size_t &iter) {
+               return JParserHook::getNull(text, size, iter, 0);
+             });
+}
+BENCHMARK(BM_GetNull)->RangeMultiplier(8)->Range(8, 1 << 15)->Complexity();
+
+// Dict insertion as parse_ does it: operator[] with a freshly parsed key,
+// then a move-assigned value.
+void BM_DictInsert(benchmark::State &state) {
+  const std::size_t count = state.range(0);
+  std::vector<qjson::string_t> keys;
+  keys.reserve(count);
+  for (std::size_t i = 0; i < count; i++)
+    keys.emplace_back("key_" + std::to_string(i * 7919));
+  for (auto _ : state) {
+    qjson::JObject dict(qjson::JDict);
+    for (const auto &key : keys)
+      dict[key] = qjson::JObject(static_cast<qjson::int_t>(key.size()));
+    benchmark::DoNotOptimize(dict);
+  }
+  state.SetComplexityN(count);
+  state.SetItemsProcessed(count * state.iterations());
+}
+BENCHMARK(BM_DictInsert)->RangeMultiplier(8)->Range(8, 1 << 15)->Complexity();
@@ -0,0 +1,157 @@
+#include "../Json.h"
+#include "corpus.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Parse and write from many threads at once. Each thread works on its own
+// data, so what is measured is contention in the shared parts: the global
+// allocator behind the default pmr resource, and the cache hierarchy.
+//
+// Besides the aggregate bytes_per_second, every run reports `efficiency`:
+// aggregate throughput over the thread count times the single-thread
+// throughput of the same benchmark (1.0 is perfect scaling). It is shown
+// only when the threads:1 run was part of the same invocation.
+
+namespace {
+constexpr std::size_t records = 256;
+
+/**
+ * @brief Single-thread throughput of each benchmark, taken from its
+ * threads:1 run.
+ */
+class ScalingReference {
+public:
+  static void report(benchmark::State &state, const char *name,
+                     double bytes,
+                     std::chrono::steady_clock::duration elapsed) {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    if (seconds <= 0)
+      return;
+    const double rate = bytes / seconds;
+    static std::mutex mutex;
+    static std::map<std::string, double, std::less<>> single;
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (state.threads() == 1)
+      single[name] = rate;
+    auto found = single.find(std::string_view(name));
+    if (found == single.end() || found->second <= 0)
+      return;
+    // Counters are summed over threads, so each adds its share.
+    state.counters["efficiency"] =
+        rate / found->second / static_cast<double>(state.threads());
+  }
+};
+
+/**
+ * @brief Times the loop of one thread, for ScalingReference.
+ */
+class ThreadClock {
+public:
+  void start() { m_start = std::chrono::steady_clock::now(); }
+  void stop() { m_elapsed = std::chrono::steady_clock::now() - m_start; }
+  std::chrono::steady_clock::duration elapsed() const { return m_elapsed; }
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+  std::chrono::steady_clock::duration m_elapsed{};
+};
+
+const qjson::JObject &shared_document() {
+  static const qjson::JObject document =
+      corpus::generate(corpus::Shape::Telemetry, 4 * records);
+  return document;
+}
+} // namespace
+
+void BM_ThreadedParse(benchmark::State &state) {
+  const std::string json =
+      corpus::generate(corpus::Shape::Telemetry, records,
+                       42 + state.thread_index())
+          .to_string();
+  ThreadClock clock;
+  clock.start();
+  for (auto _ : state) {
+    auto res = qjson::to_json(json);
+    benchmark::DoNotOptimize(res);
+  }
+  clock.stop();
+
+  const double bytes = static_cast<double>(json.size() * state.iterations());
+  ScalingReference::report(state, "parse", bytes, clock.elapsed());
+  state.SetBytesProcessed(json.size() * state.iterations());
+}
+BENCHMARK(BM_ThreadedParse)->ThreadRange(1, 64)->UseRealTime();
+
+void BM_ThreadedWrite(benchmark::State &state) {
+  const qjson::JObject jobject = corpus::generate(
+      corpus::Shape::Telemetry, records, 42 + state.thread_index());
+  std::size_t bytes = 0;
+  ThreadClock clock;
+  clock.start();
+  for (auto _ : state) {
+    auto res = jobject.to_string();
+    bytes = res.size();
+    benchmark::DoNotOptimize(res);
+  }
+  clock.stop();
+
+  ScalingReference::report(
+      state, "write", static_cast<double>(bytes * state.iterations()),
+      clock.elapsed());
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+BENCHMARK(BM_ThreadedWrite)->ThreadRange(1, 64)->UseRealTime();
+
+// Parse and write in turn, as a request handler would.
+void BM_ThreadedRoundTrip(benchmark::State &state) {
+  const std::string json =
+      corpus::generate(corpus::Shape::Twitter, records / 4,
+                       42 + state.thread_index())
+          .to_string();
+  ThreadClock clock;
+  clock.start();
+  for (auto _ : state) {
+    auto res = qjson::to_json(json).to_string();
+    benchmark::DoNotOptimize(res);
+  }
+  clock.stop();
+
+  const double bytes = static_cast<double>(json.size() * state.iterations());
+  ScalingReference::report(state, "round_trip", bytes, clock.elapsed());
+  state.SetBytesProcessed(json.size() * state.iterations());
+}
+BENCHMARK(BM_ThreadedRoundTrip)->ThreadRange(1, 64)->UseRealTime();
+
+// All threads read one document that none of them modifies: lookups
+// through the const accessors, then a full serialization.
+void BM_SharedRead(benchmark::State &state) {
+  const qjson::JObject &document = shared_document();
+  const auto &list = document["records"].getList();
+  const std::size_t bytes = document.to_string().size();
+  ThreadClock clock;
+  clock.start();
+  for (auto _ : state) {
+    qjson::double_t sum = 0;
+    for (const auto &record : list) {
+      sum += record["value"].getDouble();
+      sum += record["cpu"]["user"].getDouble();
+      sum += static_cast<qjson::double_t>(
+          record["tags"]["region"].getPMRString().size());
+    }
+    benchmark::DoNotOptimize(sum);
+    auto res = document.to_string();
+    benchmark::DoNotOptimize(res);
+  }
+  clock.stop();
+
+  ScalingReference::report(
+      state, "shared_read", static_cast<double>(bytes * state.iterations()),
+      clock.elapsed());
+  state.SetItemsProcessed(list.size() * state.iterations());
+  state.SetBytesProcessed(bytes * state.iterations());
+}
+BENCHMARK(BM_SharedRead)->ThreadRange(1, 64)->UseRealTime();
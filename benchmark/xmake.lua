@@ -6,6 +6,33 @@ target("main")
     set_languages("cxxlatest")
     set_optimize("fastest")
     set_runtimes("MD")
-    add_files("main.cpp", "../Json.cpp")
+    add_files("main.cpp", "json.cpp", "threads.cpp", "primitives.cpp",
+              "corpus.cpp", "perf_counters.cpp", "ini.cpp",
+              "alloc_counter.cpp", "../Json.cpp",
+              "../JsonSchemaParser.cpp", "../JsonShape.cpp",
+              "../JsonPatch.cpp", "../JsonValidator.cpp",
+              "../Ini.cpp")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
     add_packages("benchmark")
     add_packages("nlohmann_json")
+    add_defines("FILEPARSER_HAS_NLOHMANN")
+
+target("latency")
+    set_kind("binary")
+    set_languages("cxxlatest")
+    set_optimize("fastest")
+    set_runtimes("MD")
+    add_files("latency.cpp", "corpus.cpp", "../Json.cpp")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
+    add_packages("benchmark")
+
+target("compare")
+    set_kind("binary")
+    set_languages("cxxlatest")
+    set_optimize("fastest")
+    set_runtimes("MD")
+    add_files("compare.cpp", "../Json.cpp")